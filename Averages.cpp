@@ -6,6 +6,8 @@
 
 /**
  * Averages provides a set of averaging functions.
+ * The functions are templated on the sample type of the
+ * buffer (double or float) and always accumulate in double.
  * @author Ryan Khan Logan
  */
 
@@ -16,7 +18,8 @@
 	 * @param nFrames The number of samples in the input buffer
 	 * @return The arithmetic mean of the input buffer
 	 */
-	double mean(double *input, int nFrames){
+	template<typename T>
+	double mean(T *input, int nFrames){
 		double acc = 0;
 		for(int i = 0; i < nFrames; i++) acc += input[i];
 		return acc/nFrames;
@@ -31,7 +34,8 @@
 	 * @see math.pow()
 	 * @return The geometric mean of the input buffer
 	 */
-	double geometricMean(double *input, int nFrames){
+	template<typename T>
+	double geometricMean(T *input, int nFrames){
 		double acc = input[0];
 		for(int i = 1; i < nFrames; i++) acc *= input[i];
 		return pow(acc, 1/nFrames);
@@ -43,7 +47,8 @@
 	 * @param nFrames The number of samples in the input buffer
 	 * @return The harmonic mean of the input buffer
 	 */
-	double harmonicMean(double *input, int nFrames){
+	template<typename T>
+	double harmonicMean(T *input, int nFrames){
 		double acc = 0;
 		for(int i = 0; i < nFrames; i++) acc += 1/input[i];
 		return nFrames / acc;
@@ -56,7 +61,8 @@
 	 * @param nFrames The number of samples in the input buffer
 	 * @return The midpoint of the input buffer
 	 */
-	double midPoint(double *input, int nFrames){
+	template<typename T>
+	double midPoint(T *input, int nFrames){
 		double max = std::numeric_limits<double>::lowest();
 		double min = std::numeric_limits<double>::max();
 		for(int i = 0; i < nFrames; i++){
@@ -74,7 +80,8 @@
 	 * @param nFrames the number of samples in the input buffer
 	 * @return The peak value of the input buffer
 	 */
-	double peak(double *input, int nFrames){
+	template<typename T>
+	double peak(T *input, int nFrames){
 		double max = std::numeric_limits<double>::lowest();
 		for(int i = 0; i < nFrames; i++){
 			if(input[i] > 0){
@@ -94,7 +101,8 @@
 	 * @param nFrames The number of samples in the input buffer
 	 * @return The absolute average of the input buffer
 	 */
-	double absAvg(double *input, int nFrames){
+	template<typename T>
+	double absAvg(T *input, int nFrames){
 		double acc;
 		for(int i = 0; i < nFrames; i++){
 			if(input[i] >= 0) acc += input[i];
@@ -112,7 +120,8 @@
 	 * @see math.sqrt()
 	 * @return The RMS of the input buffer
 	 */
-	double rms(double *input, int nFrames){
+	template<typename T>
+	double rms(T *input, int nFrames){
 		double acc = 0;
 		for(int i = 0; i < nFrames; i++){
 			acc += input[i]*input[i];
@@ -129,7 +138,8 @@
 	 * @see math.cbrt
 	 * @return The cubic mean of the input buffer
 	 */
-	/*double cubicMean(double *input, int nFrames){
+	/*template<typename T>
+	double cubicMean(T *input, int nFrames){
 		double acc = 0;
 		for(int i = 0; i < nFrames; i++){
 			acc += input[i]*input[i]*input[i];
@@ -144,7 +154,8 @@
 	 * @param nFrames The number of samples in the input buffer
 	 * @return the absolute midpoint of the input buffer
 	 */
-	double absMidPoint(double *input, int nFrames){
+	template<typename T>
+	double absMidPoint(T *input, int nFrames){
 		double max = std::numeric_limits<double>::lowest();
 		double min = std::numeric_limits<double>::max();
 		for(int i = 0; i < nFrames; i++){
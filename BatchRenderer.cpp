@@ -0,0 +1,337 @@
+#include "BatchRenderer.h"
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+/**
+ * Creates a renderer with no variant and no job
+ * @param fs The sample rate
+ * @param n The number of threads, the number of cores if 0
+ */
+BatchRenderer::BatchRenderer(double fs, int n) : done(0), failed(0){
+	Fs = fs;
+	nThreads = n > 0 ? n : (int)std::thread::hardware_concurrency();
+	if(nThreads < 1) nThreads = 1;
+	maxModes = 0;
+	queues = 0;
+	startTime = 0;
+	seconds = 0;
+	progress = 0;
+	progressUser = 0;
+}
+
+BatchRenderer::~BatchRenderer(){
+	delete[] queues;
+}
+
+double BatchRenderer::now(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * addVariant adds a mode table
+ * @param r The frequency ratios of the modes to the fundamental
+ * @param a The gains of the modes
+ * @param b The bandwidths of the modes in octaves
+ * @param n The number of modes
+ * @return The variant number, or -1 if n < 1 or a ratio or a
+ * bandwidth is not positive
+ */
+int BatchRenderer::addVariant(const double *r, const double *a, const double *b, int n){
+	if(n < 1) return -1;
+	for(int i = 0; i < n; i++){
+		if(!(r[i] > 0) || !(b[i] > 0)) return -1;
+	}
+	variantStart.push_back((int)ratios.size());
+	variantModes.push_back(n);
+	ratios.insert(ratios.end(), r, r + n);
+	amps.insert(amps.end(), a, a + n);
+	bws.insert(bws.end(), b, b + n);
+	if(n > maxModes) maxModes = n;
+	return (int)variantStart.size() - 1;
+}
+
+/**
+ * addJob adds one note to render
+ * @param f0 The fundamental in Hz
+ * @param nFrames The length in samples
+ * @param variant The mode table
+ * @param path The WAV file to write
+ * @return false IFF f0 is not positive, the variant does not exist,
+ * nFrames < 1 or above BATCH_MAX_FRAMES or the path is too long
+ */
+bool BatchRenderer::addJob(double f0, int nFrames, int variant, const char *path){
+	if(!(f0 > 0)) return false;
+	if(variant < 0 || variant >= getNumVariants() || nFrames < 1) return false;
+	if((unsigned long)nFrames > BATCH_MAX_FRAMES) return false;
+	if(strlen(path) >= BATCH_PATH_MAX) return false;
+	BatchJob j;
+	j.f0 = f0;
+	j.nFrames = nFrames;
+	j.variant = variant;
+	strcpy(j.path, path);
+	jobs.push_back(j);
+	return true;
+}
+
+/**
+ * addLibrary adds every combination of MIDI pitch, length and
+ * variant, written to dir/v<variant>_n<note>_l<length>.wav
+ * @param dir The output directory, which must exist
+ * @param firstNote The MIDI number of the lowest note
+ * @param nNotes The number of notes
+ * @param lengths The lengths in samples
+ * @param nLengths The number of lengths
+ * @return The number of jobs added
+ */
+int BatchRenderer::addLibrary(const char *dir, int firstNote, int nNotes, const int *lengths, int nLengths){
+	int added = 0;
+	char path[BATCH_PATH_MAX];
+	for(int v = 0; v < getNumVariants(); v++){
+		for(int n = firstNote; n < firstNote + nNotes; n++){
+			double f0 = 440 * pow(2.0, (n - 69) / 12.0);
+			for(int l = 0; l < nLengths; l++){
+				int len = snprintf(path, BATCH_PATH_MAX, "%s/v%d_n%03d_l%d.wav", dir, v, n, lengths[l]);
+				if(len < 0 || len >= BATCH_PATH_MAX) continue;
+				if(addJob(f0, lengths[l], v, path)) added++;
+			}
+		}
+	}
+	return added;
+}
+
+/**
+ * setProgress sets the function called after each note
+ * @param p The function, 0 for none
+ * @param user A pointer given back to the function
+ */
+void BatchRenderer::setProgress(BatchProgress p, void *user){
+	progress = p;
+	progressUser = user;
+}
+
+/**
+ * clearJobs removes every job, the variants are kept
+ */
+void BatchRenderer::clearJobs(){
+	jobs.clear();
+}
+
+/**
+ * nextJob takes a job from the head of a worker's queue. When it
+ * is empty, it steals the last job of the queue with the most
+ * jobs left, so the long tails of the busy workers are split.
+ * @param w The worker
+ * @return The job, or -1 when every queue is empty
+ */
+int BatchRenderer::nextJob(int w){
+	{
+		std::lock_guard<std::mutex> guard(queues[w].lock);
+		if(queues[w].head < queues[w].tail) return queues[w].head++;
+	}
+	while(true){
+		int victim = -1;
+		int most = 0;
+		for(int q = 0; q < nThreads; q++){
+			std::lock_guard<std::mutex> guard(queues[q].lock);
+			int left = queues[q].tail - queues[q].head;
+			if(left > most){
+				most = left;
+				victim = q;
+			}
+		}
+		if(victim < 0) return -1;
+		std::lock_guard<std::mutex> guard(queues[victim].lock);
+		//the queue may have been emptied since it was counted
+		if(queues[victim].head < queues[victim].tail) return --queues[victim].tail;
+	}
+}
+
+/**
+ * renderJob streams one note to its file, BATCH_CHUNK samples at
+ * a time. The envelope spans the length of the job, so the file
+ * holds the same note as generateNote would render.
+ * @param synth The synthesizer of the worker, set to the variant of the job
+ * @param job The job
+ * @param block A buffer of BATCH_CHUNK doubles
+ * @param scratch A buffer of BATCH_CHUNK floats
+ * @return false IFF the file could not be written
+ */
+bool BatchRenderer::renderJob(ModalURB &synth, const BatchJob &job, double *block, float *scratch){
+	FILE *f = openWav(job.path, job.nFrames, Fs);
+	if(!f) return false;
+	bool ok = synth.startNote(job.f0, 1, job.nFrames);
+	for(int i = 0; i < job.nFrames && ok; i += BATCH_CHUNK){
+		int n = job.nFrames - i < BATCH_CHUNK ? job.nFrames - i : BATCH_CHUNK;
+		synth.streamNote(block, n);
+		ok = writeChunk(f, block, n, scratch);
+	}
+	if(fclose(f) != 0) ok = false;
+	return ok;
+}
+
+/**
+ * work is the loop of a worker thread. The synthesizer and the
+ * scratch buffers are the worker's own, so the workers share
+ * nothing but the queues and the counters.
+ * @param w The worker
+ */
+void BatchRenderer::work(int w){
+	ModalURB synth(Fs, 1, maxModes);
+	double *block = new double[BATCH_CHUNK];
+	float *scratch = new float[BATCH_CHUNK];
+	int variant = -1;
+
+	int j;
+	while((j = nextJob(w)) >= 0){
+		const BatchJob &job = jobs[j];
+		if(job.variant != variant){
+			variant = job.variant;
+			int s = variantStart[variant];
+			synth.setModes(&ratios[s], &amps[s], &bws[s], variantModes[variant]);
+		}
+		if(!renderJob(synth, job, block, scratch)) failed++;
+
+		int d = ++done;
+		if(progress){
+			std::lock_guard<std::mutex> guard(progressLock);
+			double t = now() - startTime;
+			progress(d, (int)jobs.size(), t > 0 ? d / t : 0, progressUser);
+		}
+	}
+
+	delete[] block;
+	delete[] scratch;
+}
+
+/**
+ * run renders every job and waits for the threads. The jobs are
+ * given to the workers in contiguous ranges, so that a worker
+ * renders notes of the same variant in a row.
+ * @return true IFF every file was written
+ */
+bool BatchRenderer::run(){
+	done = 0;
+	failed = 0;
+	seconds = 0;
+	int nJobs = (int)jobs.size();
+	if(nJobs == 0) return true;
+
+	delete[] queues;
+	queues = new BatchQueue[nThreads];
+	for(int w = 0; w < nThreads; w++){
+		queues[w].head = (int)((long long)nJobs * w / nThreads);
+		queues[w].tail = (int)((long long)nJobs * (w + 1) / nThreads);
+	}
+
+	startTime = now();
+	std::vector<std::thread> threads;
+	for(int w = 1; w < nThreads; w++) threads.push_back(std::thread(&BatchRenderer::work, this, w));
+	work(0);
+	for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+	seconds = now() - startTime;
+
+	delete[] queues;
+	queues = 0;
+	return failed == 0;
+}
+
+/**
+ * getNotesPerSecond
+ * @return The throughput of the last run, 0 before the first one
+ */
+double BatchRenderer::getNotesPerSecond(){
+	if(seconds <= 0) return 0;
+	return done / seconds;
+}
+
+//little endian writers for the WAV header
+static void putU16(unsigned char *p, unsigned v){
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+static void putU32(unsigned char *p, unsigned long v){
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+/**
+ * writeWav writes a mono 32 bit float WAV file, converting the
+ * samples in chunks of BATCH_CHUNK
+ * @param path The file
+ * @param samples The samples
+ * @param nFrames The number of samples, at most BATCH_MAX_FRAMES
+ * @param fs The sample rate
+ * @param scratch A buffer of BATCH_CHUNK floats
+ * @return false IFF the file could not be written or nFrames is out of range
+ */
+bool BatchRenderer::writeWav(const char *path, const double *samples, int nFrames, double fs, float *scratch){
+	FILE *f = openWav(path, nFrames, fs);
+	if(!f) return false;
+	bool ok = true;
+	for(int i = 0; i < nFrames && ok; i += BATCH_CHUNK){
+		int n = nFrames - i < BATCH_CHUNK ? nFrames - i : BATCH_CHUNK;
+		ok = writeChunk(f, samples + i, n, scratch);
+	}
+	if(fclose(f) != 0) ok = false;
+	return ok;
+}
+
+/**
+ * openWav creates a mono 32 bit float WAV file and writes its header
+ * @param path The file
+ * @param nFrames The number of samples that will be written, at
+ * most BATCH_MAX_FRAMES
+ * @param fs The sample rate
+ * @return The file, or 0 if it could not be written or nFrames is out of range
+ */
+FILE *BatchRenderer::openWav(const char *path, int nFrames, double fs){
+	if(nFrames < 0 || (unsigned long)nFrames > BATCH_MAX_FRAMES) return 0;
+	unsigned long dataBytes = (unsigned long)nFrames * 4;
+	unsigned long rate = (unsigned long)(fs + 0.5);
+
+	//RIFF, fmt (WAVE_FORMAT_IEEE_FLOAT), fact and data chunk headers
+	unsigned char h[58];
+	memcpy(h, "RIFF", 4);
+	putU32(h + 4, 50 + dataBytes);
+	memcpy(h + 8, "WAVEfmt ", 8);
+	putU32(h + 16, 18);
+	putU16(h + 20, 3);
+	putU16(h + 22, 1);
+	putU32(h + 24, rate);
+	putU32(h + 28, rate * 4);
+	putU16(h + 32, 4);
+	putU16(h + 34, 32);
+	putU16(h + 36, 0);
+	memcpy(h + 38, "fact", 4);
+	putU32(h + 42, 4);
+	putU32(h + 46, nFrames);
+	memcpy(h + 50, "data", 4);
+	putU32(h + 54, dataBytes);
+
+	FILE *f = fopen(path, "wb");
+	if(!f) return 0;
+	if(fwrite(h, 1, sizeof(h), f) != sizeof(h)){
+		fclose(f);
+		return 0;
+	}
+	return f;
+}
+
+/**
+ * writeChunk converts samples to float and appends them to a file
+ * @param f The file
+ * @param samples The samples
+ * @param n The number of samples, at most BATCH_CHUNK
+ * @param scratch A buffer of BATCH_CHUNK floats
+ * @return false IFF the samples could not be written
+ */
+bool BatchRenderer::writeChunk(FILE *f, const double *samples, int n, float *scratch){
+	for(int k = 0; k < n; k++) scratch[k] = (float)samples[k];
+	return fwrite(scratch, sizeof(float), n, f) == (size_t)n;
+}
@@ -0,0 +1,221 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+//include
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include "ModalURB.h"
+
+//samples rendered, converted and written at a time
+#define BATCH_CHUNK 4096
+#define BATCH_PATH_MAX 512
+//longest note whose sizes fit the 32 bit fields of the WAV header
+#define BATCH_MAX_FRAMES ((0xFFFFFFFFul - 50) / 4)
+
+/**
+ * One note of a batch: a file to render
+ * @see BatchRenderer
+ */
+struct BatchJob{
+	double f0;						//fundamental in Hz
+	int nFrames;					//length in samples
+	int variant;					//mode table, @see BatchRenderer::addVariant
+	char path[BATCH_PATH_MAX];		//WAV file to write
+};
+
+/**
+ * Range of jobs of one worker. The owner takes jobs from the
+ * head, idle workers steal them from the tail.
+ */
+struct BatchQueue{
+	std::mutex lock;
+	int head;
+	int tail;
+};
+
+/**
+ * Called after each note of a batch, from the worker that
+ * rendered it. Calls are serialized.
+ * @param done The number of notes finished
+ * @param total The number of notes of the batch
+ * @param notesPerSecond The throughput since the start of the batch
+ * @param user The pointer given to setProgress
+ */
+typedef void (*BatchProgress)(int done, int total, double notesPerSecond, void *user);
+
+/**
+ * BatchRenderer exports a ModalURB instrument as a sample
+ * library: every note of a list of jobs (pitch, length and mode
+ * table variant) is rendered and written to a 32 bit float mono
+ * WAV file. The jobs are split in contiguous ranges over a pool
+ * of threads; a thread that runs out of work steals jobs from the
+ * end of the busiest range. Each thread has its own synthesizer
+ * and two scratch buffers of BATCH_CHUNK samples, allocated once
+ * per run: a note is streamed with ModalURB::startNote and
+ * streamNote, and each chunk is written as soon as it is
+ * rendered, so the memory used does not depend on the length of
+ * the notes.
+ * @see ModalURB
+ */
+class BatchRenderer{
+protected:
+	double Fs;
+	int nThreads;
+
+	//mode tables, concatenated
+	std::vector<double> ratios;
+	std::vector<double> amps;
+	std::vector<double> bws;
+	std::vector<int> variantStart;
+	std::vector<int> variantModes;
+	int maxModes;
+
+	std::vector<BatchJob> jobs;
+
+	BatchQueue *queues;				//one per thread during run
+	std::atomic<int> done;
+	std::atomic<int> failed;
+	double startTime;
+	double seconds;					//length of the last run
+
+	std::mutex progressLock;
+	BatchProgress progress;
+	void *progressUser;
+
+	/**
+	 * nextJob takes a job from a worker's queue, or steals one
+	 * @param w The worker
+	 * @return The job, or -1 when every queue is empty
+	 */
+	int nextJob(int w);
+
+	/**
+	 * work is the loop of a worker thread
+	 * @param w The worker
+	 */
+	void work(int w);
+
+	/**
+	 * renderJob streams one note to its file
+	 * @param synth The synthesizer of the worker, set to the variant of the job
+	 * @param job The job
+	 * @param block A buffer of BATCH_CHUNK doubles
+	 * @param scratch A buffer of BATCH_CHUNK floats
+	 * @return false IFF the file could not be written
+	 */
+	bool renderJob(ModalURB &synth, const BatchJob &job, double *block, float *scratch);
+
+	/**
+	 * openWav creates a mono 32 bit float WAV file and writes its header
+	 * @param path The file
+	 * @param nFrames The number of samples that will be written, at
+	 * most BATCH_MAX_FRAMES
+	 * @param fs The sample rate
+	 * @return The file, or 0 if it could not be written or nFrames is out of range
+	 */
+	static FILE *openWav(const char *path, int nFrames, double fs);
+
+	/**
+	 * writeChunk converts samples to float and appends them to a file
+	 * @param f The file
+	 * @param samples The samples
+	 * @param n The number of samples, at most BATCH_CHUNK
+	 * @param scratch A buffer of BATCH_CHUNK floats
+	 * @return false IFF the samples could not be written
+	 */
+	static bool writeChunk(FILE *f, const double *samples, int n, float *scratch);
+
+	static double now();
+
+public:
+	/**
+	 * Creates a renderer with no variant and no job
+	 * @param fs The sample rate
+	 * @param n The number of threads, the number of cores if 0
+	 */
+	BatchRenderer(double fs, int n = 0);
+
+	~BatchRenderer();
+
+	/**
+	 * addVariant adds a mode table
+	 * @param r The frequency ratios of the modes to the fundamental
+	 * @param a The gains of the modes
+	 * @param b The bandwidths of the modes in octaves
+	 * @param n The number of modes
+	 * @return The variant number, or -1 if n < 1 or a ratio or a
+	 * bandwidth is not positive
+	 * @see ModalURB::setModes
+	 */
+	int addVariant(const double *r, const double *a, const double *b, int n);
+
+	/**
+	 * addJob adds one note to render
+	 * @param f0 The fundamental in Hz
+	 * @param nFrames The length in samples
+	 * @param variant The mode table
+	 * @param path The WAV file to write
+	 * @return false IFF f0 is not positive, the variant does not exist,
+	 * nFrames < 1 or above BATCH_MAX_FRAMES or the path is too long
+	 */
+	bool addJob(double f0, int nFrames, int variant, const char *path);
+
+	/**
+	 * addLibrary adds every combination of MIDI pitch, length and
+	 * variant, written to dir/v<variant>_n<note>_l<length>.wav
+	 * @param dir The output directory, which must exist
+	 * @param firstNote The MIDI number of the lowest note
+	 * @param nNotes The number of notes
+	 * @param lengths The lengths in samples
+	 * @param nLengths The number of lengths
+	 * @return The number of jobs added
+	 */
+	int addLibrary(const char *dir, int firstNote, int nNotes, const int *lengths, int nLengths);
+
+	/**
+	 * setProgress sets the function called after each note
+	 * @param p The function, 0 for none
+	 * @param user A pointer given back to the function
+	 */
+	void setProgress(BatchProgress p, void *user);
+
+	/**
+	 * run renders every job and waits for the threads. The jobs are
+	 * kept, so run can be called again.
+	 * @return true IFF every file was written
+	 */
+	bool run();
+
+	int getNumJobs(){return (int)jobs.size();}
+	int getNumVariants(){return (int)variantStart.size();}
+	int getNumDone(){return done.load();}
+	int getNumFailed(){return failed.load();}
+	int getNumThreads(){return nThreads;}
+	double getSeconds(){return seconds;}
+
+	/**
+	 * getNotesPerSecond
+	 * @return The throughput of the last run, 0 before the first one
+	 */
+	double getNotesPerSecond();
+
+	/**
+	 * clearJobs removes every job, the variants are kept
+	 */
+	void clearJobs();
+
+	/**
+	 * writeWav writes a mono 32 bit float WAV file, converting the
+	 * samples in chunks of BATCH_CHUNK
+	 * @param path The file
+	 * @param samples The samples
+	 * @param nFrames The number of samples, at most BATCH_MAX_FRAMES
+	 * @param fs The sample rate
+	 * @param scratch A buffer of BATCH_CHUNK floats
+	 * @return false IFF the file could not be written or nFrames is out of range
+	 */
+	static bool writeWav(const char *path, const double *samples, int nFrames, double fs, float *scratch);
+};
+#endif
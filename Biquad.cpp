@@ -1,4 +1,18 @@
 #include "Biquad.h"
+#include "BiquadCache.h"
+#include "FastMath.h"
+#include "StaticBiquad.h"
+#include <thread>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//minimum number of samples per thread in processBufferParallel
+#define PARALLEL_MIN_CHUNK 8192
 
 /**
  * Creates a filter with all parameters initialized to 0
@@ -18,6 +32,13 @@
 Biquad::Biquad(unsigned int m, unsigned int bwm){
 	mode = m;
 	BWMode = bwm;
+	smoothInterval = 0;
+	hasTargets = false;
+	fastMath = false;
+	lookaheadDirty = true;
+	dBG = 0;
+	gain = 1;
+	alphaPrime = 0;
 	initHist();
 
 	switch(BWMode){
@@ -58,6 +79,15 @@ Biquad::Biquad(unsigned int m, unsigned int bwm){
 Biquad::Biquad(unsigned int m, unsigned int bwm, double fs, double f, double q, double dbg){
 	mode = m;
 	BWMode = bwm;
+	smoothInterval = 0;
+	hasTargets = false;
+	fastMath = false;
+	lookaheadDirty = true;
+	//the gain of a shelf designed with Q or BW
+	dBG = dbg;
+	gain = 1;
+	alphaPrime = 0;
+	updateGain();
 
 	switch(bwm){
 	case 1:
@@ -95,8 +125,7 @@ Biquad::Biquad(unsigned int m, unsigned int bwm, double fs, double f, double q,
  * @param q Holds q value of bwm=0; -3dB bandwidth if bwm=1;
 			dB/octave slope if bwm=2
  */
-Biquad::Biquad(unsigned int m, unsigned int bwm, double fs, double f, double q){
-	Biquad(m, bwm, fs, f, q, 0.0);
+Biquad::Biquad(unsigned int m, unsigned int bwm, double fs, double f, double q) : Biquad(m, bwm, fs, f, q, 0.0){
 }
 
 bool Biquad::setParamsSlope(double fs, double f, double s, double dbg){
@@ -107,11 +136,15 @@ bool Biquad::setParamsSlope(double fs, double f, double s, double dbg){
 	if(s >= 0) slope = s;
 	dBG = dbg;
 
-	updateOmega(true);
-	updateGain();
-	updateAlpha();
-	updateAlphaPrime();
-	updateCoFs();
+	if(!loadCachedDesign()){
+		updateOmega(true);
+		updateGain();
+		updateAlpha();
+		updateAlphaPrime();
+		updateCoFs();
+		storeCachedDesign();
+	}
+	return true;
 }
 
 void Biquad::initHist(){
@@ -120,6 +153,8 @@ void Biquad::initHist(){
 	x2 = 0;
 	y1 = 0;
 	y2 = 0;
+	hot.s1 = 0;
+	hot.s2 = 0;
 }
 
 bool Biquad::setParamsBW(double fs, double f, double b){
@@ -128,9 +163,12 @@ bool Biquad::setParamsBW(double fs, double f, double b){
 	if(fs >= 0) Fs = fs;
 	if(f >= 0) fc = f;
 	if(b >= 0) BW = b;
-	updateOmega(true);
-	updateAlpha();
-	updateCoFs();
+	if(!loadCachedDesign()){
+		updateOmega(true);
+		updateAlpha();
+		updateCoFs();
+		storeCachedDesign();
+	}
 	return true;
 }
 
@@ -138,9 +176,13 @@ void Biquad::setParamsQ(double fs, double f, double q){
 	if(fs >= 0) Fs = fs;
 	if(f >= 0) fc = f;
 	if (q >= 0) Q = q;
-	updateOmega(true);
-	updateAlpha();
-	updateCoFs();
+	if(!loadCachedDesign()){
+		updateOmega(true);
+		updateAlpha();
+		updateAlphaPrime();
+		updateCoFs();
+		storeCachedDesign();
+	}
 }
 
 /**
@@ -170,7 +212,7 @@ bool Biquad::setFs(double f, bool updateDeps){
 		updateSinW0();
 		updateCosW0();
 		updateAlpha();
-		if(BWMode == 2 && (mode==5 || mode==6)) updateAlphaPrime();
+		updateAlphaPrime();
 		updateCoFs();
 	}
 	return true;
@@ -203,7 +245,7 @@ bool Biquad::setFc(double f, bool updateDeps){
 		updateSinW0();
 		updateCosW0();
 		updateAlpha();
-		if(BWMode == 2 && (mode==5 || mode==6)) updateAlphaPrime();
+		updateAlphaPrime();
 		updateCoFs();
 	}
 	return true;
@@ -286,14 +328,14 @@ bool Biquad::setSlope(double s, bool updateDeps){
 void Biquad::updateAlpha(){
 	switch(BWMode){
 	case 1:
-		alpha = (sinW0 * sinh( (LN2) / 2 * BW * omega0/sinW0));
+		alpha = biquadAlpha<OctaveBW>(sinW0, omega0, BW, gain, fastMath);
 		break;
 	case 2:
-		alpha = sinW0/2 * sqrt( (gain+1/gain)*(1/slope-1)+2 );
+		alpha = biquadAlpha<SlopeBW>(sinW0, omega0, slope, gain, fastMath);
 		break;
 	case 0:
 	default:
-		alpha = sinW0 / (2 * Q);
+		alpha = biquadAlpha<QBW>(sinW0, omega0, Q, gain, fastMath);
 	}
 }
 
@@ -322,7 +364,8 @@ bool Biquad::updateAlphaPrime(){
  */
 bool Biquad::updateGain(){
 	if(mode==5 || mode ==6){
-		gain = pow(10, dBG/40);
+		if(fastMath) gain = fastPow10(dBG/40);
+		else gain = pow(10, dBG/40);
 		return true;
 	}
 	else return false;
@@ -351,7 +394,8 @@ void Biquad::updateOmega(bool updateTrigs){
  * @see omega0
  */
 void Biquad::updateCosW0(){
-	cosW0 = cos(omega0);
+	if(fastMath) cosW0 = fastCos(omega0);
+	else cosW0 = cos(omega0);
 }
 
 /**
@@ -361,7 +405,8 @@ void Biquad::updateCosW0(){
  * @see omega0
  */
 void Biquad::updateSinW0(){
-	sinW0 = sin(omega0);
+	if(fastMath) sinW0 = fastSin(omega0);
+	else sinW0 = sin(omega0);
 }
 
 /**
@@ -370,74 +415,56 @@ void Biquad::updateSinW0(){
  * @see updateAs()
  */
 void Biquad::updateCoFs(){
-	//switch to update a value
-	switch(mode){
-	case 5:break; //case 5 and 6 will be updated later
-	case 6:break;
-	case 0:
-	case 1:
-	case 2:
-	case 3:
-	case 4:
-	default:
-		updateAs();
-	}
-
-	//switch to update Bs
+	//one switch to pick the specialized design, see StaticBiquad.h
+	double as[3];
+	double bs[3];
 	switch(mode){
 	case 1:
+		biquadCoFs<LowPass>(cosW0, alpha, alphaPrime, gain, bs, as);
+		break;
 	case 2:
-		if(mode==1) b1 = 1 - cosW0;
-		else if(mode==2) b1 = 1 + cosW0;
-		b0 = b1/2;
-		b2 = b0;
-		if(mode==2) b1 *= -1;
+		biquadCoFs<HighPass>(cosW0, alpha, alphaPrime, gain, bs, as);
 		break;
 	case 3:
-		b0 = 1;
-		b2 = 1;
+		biquadCoFs<Notch>(cosW0, alpha, alphaPrime, gain, bs, as);
+		break;
 	case 4:
-		b1 = a1;
-		if(mode==3)break;
-		b0 = a2;
-		b2 = a0;
+		biquadCoFs<AllPass>(cosW0, alpha, alphaPrime, gain, bs, as);
 		break;
 	case 5:
+		biquadCoFs<LowShelf>(cosW0, alpha, alphaPrime, gain, bs, as);
+		break;
 	case 6:
-		if(true){
-			//calculate some intermediate vars
-			double gp = gain+1;
-			double gm = gain-1;
-			double mc = gm*cosW0;
-			double pc = gp*cosW0;
-			double pmm = gp - mc;
-			double mmp = gm - pc;
-			double ppm = gp + mc;
-			double mpp = gm + pc;
-			if(mode==5){
-				b0 = gain * (pmm + alphaPrime);
-				b1 = 2 * gain * mmp;
-				b2 = gain * (pmm - alphaPrime);
-				a0 = ppm + alphaPrime;
-				a1 = -2 * mpp;
-				a2 = ppm - alphaPrime;
-			}
-			else if(mode==6){
-				b0 = gain * (ppm + alphaPrime);
-				b1 = -2 * gain * mpp;
-				b2 = gain * (ppm -  alphaPrime);
-				a0 = pmm + alphaPrime;
-				a1 = -2 * mmp;
-				a2 = pmm - alphaPrime;
-			}
-		}
+		biquadCoFs<HighShelf>(cosW0, alpha, alphaPrime, gain, bs, as);
 		break;
 	case 0:
 	default:
-		b0 = alpha;
-		b1 = 0;
-		b2 = -1 * alpha;
+		biquadCoFs<BandPass>(cosW0, alpha, alphaPrime, gain, bs, as);
 	}
+	b0 = bs[0];
+	b1 = bs[1];
+	b2 = bs[2];
+	a0 = as[0];
+	a1 = as[1];
+	a2 = as[2];
+
+	normalizeCoFs();
+}
+
+/**
+ * normalizeCoFs divides the coefficients by a0 and stores
+ * them for use by processBufferTDF2. Called by updateCoFs.
+ * @see updateCoFs()
+ * @see processBufferTDF2()
+ */
+void Biquad::normalizeCoFs(){
+	double inv = 1 / a0;
+	hot.b0 = b0 * inv;
+	hot.b1 = b1 * inv;
+	hot.b2 = b2 * inv;
+	hot.a1 = a1 * inv;
+	hot.a2 = a2 * inv;
+	lookaheadDirty = true;
 }
 
 /**
@@ -669,7 +696,7 @@ void Biquad::updateA1(){
 		a1 = -2 * ((gain-1) + (gain+1)*cosW0);
 		break;
 	case 6:
-		a1 = 2 * ((gain-1) + (gain+1)*cosW0);
+		a1 = 2 * ((gain-1) - (gain+1)*cosW0);
 		break;
 	case 0:
 	case 1:
@@ -706,6 +733,561 @@ void Biquad::updateA2(){
 	}
 }
 
+/**
+ * getDesignKey fills in the parameters identifying the
+ * current design in BiquadCache.
+ * @param k Pass by call key
+ * @see BiquadCache
+ */
+void Biquad::getDesignKey(BiquadDesignKey &k){
+	k.mode = mode;
+	k.BWMode = BWMode;
+	k.Fs = Fs;
+	k.fc = fc;
+	k.bw = getBWParam();
+	if(mode == 5 || mode == 6) k.dBG = dBG;
+	else k.dBG = 0;
+	k.fastMath = fastMath;
+}
+
+/**
+ * loadCachedDesign copies the design matching the current
+ * parameters from BiquadCache, if the cache is enabled.
+ * @see BiquadCache
+ * @return true IFF the design was loaded
+ */
+bool Biquad::loadCachedDesign(){
+	if(!BiquadCache::isEnabled()) return false;
+
+	BiquadDesignKey k;
+	BiquadDesign d;
+	getDesignKey(k);
+	if(!BiquadCache::lookup(k, d)) return false;
+
+	omega0 = d.omega0;
+	cosW0 = d.cosW0;
+	sinW0 = d.sinW0;
+	alpha = d.alpha;
+	alphaPrime = d.alphaPrime;
+	gain = d.gain;
+	b0 = d.b0;
+	b1 = d.b1;
+	b2 = d.b2;
+	a0 = d.a0;
+	a1 = d.a1;
+	a2 = d.a2;
+	normalizeCoFs();
+	return true;
+}
+
+/**
+ * storeCachedDesign adds the current design to BiquadCache,
+ * if the cache is enabled.
+ * @see BiquadCache
+ */
+void Biquad::storeCachedDesign(){
+	if(!BiquadCache::isEnabled()) return;
+
+	BiquadDesignKey k;
+	BiquadDesign d;
+	getDesignKey(k);
+
+	d.omega0 = omega0;
+	d.cosW0 = cosW0;
+	d.sinW0 = sinW0;
+	d.alpha = alpha;
+	d.alphaPrime = alphaPrime;
+	d.gain = gain;
+	d.b0 = b0;
+	d.b1 = b1;
+	d.b2 = b2;
+	d.a0 = a0;
+	d.a1 = a1;
+	d.a2 = a2;
+	BiquadCache::store(k, d);
+}
+
+/**
+ * redesign recomputes every intermediate parameter and the
+ * coefficients from the user parameters.
+ * @see updateOmega()
+ * @see updateGain()
+ * @see updateAlpha()
+ * @see updateAlphaPrime()
+ * @see updateCoFs()
+ */
+void Biquad::redesign(){
+	updateOmega(true);
+	updateGain();
+	updateAlpha();
+	updateAlphaPrime();
+	updateCoFs();
+}
+
+/**
+ * getBWParam returns the bandwidth parameter used by the
+ * current BWMode.
+ * @return Q if BWMode is 0; BW if BWMode is 1; slope if BWMode is 2
+ */
+double Biquad::getBWParam(){
+	switch(BWMode){
+	case 1:
+		return BW;
+	case 2:
+		return slope;
+	case 0:
+	default:
+		return Q;
+	}
+}
+
+/**
+ * setBWParam sets the bandwidth parameter used by the current
+ * BWMode without updating any dependant parameter.
+ * @param b Q if BWMode is 0; BW if BWMode is 1; slope if BWMode is 2
+ */
+void Biquad::setBWParam(double b){
+	switch(BWMode){
+	case 1:
+		BW = b;
+		break;
+	case 2:
+		slope = b;
+		break;
+	case 0:
+	default:
+		Q = b;
+	}
+}
+
+/**
+ * setFastMath selects the polynomial approximations of FastMath
+ * instead of libm for the design of the filter. The filter is
+ * redesigned with the new setting.
+ * @param f IFF true the design uses FastMath
+ * @see FastMath.h
+ */
+void Biquad::setFastMath(bool f){
+	fastMath = f;
+	redesign();
+}
+
+/**
+ * setSmoothing enables parameter smoothing for
+ * processBufferSmoothed. The filter is redesigned every
+ * interval samples and the normalized coefficients are
+ * linearly interpolated in between. Typical values are 16
+ * to 64 samples.
+ * @param interval The number of samples between two designs. 0 disables smoothing.
+ * @return true IFF interval is valid
+ */
+bool Biquad::setSmoothing(int interval){
+	if(interval < 0) return false;
+	smoothInterval = interval;
+	return true;
+}
+
+/**
+ * setTargets gives the parameters that should be reached at
+ * the end of the next call to processBufferSmoothed. The
+ * parameters glide linearly from their current values.
+ * @param f The target center frequency
+ * @param b The target Q, BW or slope depending on BWMode
+ * @param dbg The target gain in dB. Only used by shelving filters.
+ * @see processBufferSmoothed()
+ */
+void Biquad::setTargets(double f, double b, double dbg){
+	fcTarget = f;
+	bwTarget = b;
+	dBGTarget = dbg;
+	hasTargets = true;
+}
+
+/**
+ * processBufferSmoothed applies the filter while the
+ * parameters glide toward the values given to setTargets.
+ * The design runs once every smoothing interval and the
+ * normalized coefficients are interpolated per sample, which
+ * avoids zipper noise without a full design per sample. If
+ * smoothing is off or no targets are pending it behaves
+ * like processBufferTDF2.
+ * @param input A double array of size nFrames holding the intput signal
+ * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+ * @param nFrames The number of samples in the input and output buffer.
+ * @see setSmoothing()
+ * @see setTargets()
+ */
+void Biquad::processBufferSmoothed(double *input, double *output, int nFrames){
+	if(smoothInterval == 0 || !hasTargets || nFrames <= 0){
+		processBufferTDF2(input, output, nFrames);
+		return;
+	}
+	ScopedNoDenormals noDenormals;
+
+	//starting point of the glide
+	double f0 = fc;
+	double bw0 = getBWParam();
+	double g0 = dBG;
+
+	double cb0 = hot.b0, cb1 = hot.b1, cb2 = hot.b2;
+	double ca1 = hot.a1, ca2 = hot.a2;
+	double z1 = hot.s1, z2 = hot.s2;
+
+	for(int start = 0; start < nFrames; start += smoothInterval){
+		int n = nFrames - start;
+		if(n > smoothInterval) n = smoothInterval;
+
+		//design at the end of this interval
+		double frac = (double)(start + n) / nFrames;
+		fc = f0 + (fcTarget - f0) * frac;
+		setBWParam(bw0 + (bwTarget - bw0) * frac);
+		dBG = g0 + (dBGTarget - g0) * frac;
+		redesign();
+
+		//per sample increments of the coefficients
+		double inv = 1.0 / n;
+		double db0 = (hot.b0 - cb0) * inv, db1 = (hot.b1 - cb1) * inv, db2 = (hot.b2 - cb2) * inv;
+		double da1 = (hot.a1 - ca1) * inv, da2 = (hot.a2 - ca2) * inv;
+
+		for(int i = start; i < start + n; i++){
+			cb0 += db0; cb1 += db1; cb2 += db2;
+			ca1 += da1; ca2 += da2;
+
+			double x = input[i];
+			double y = cb0 * x + z1;
+			z1 = cb1 * x - ca1 * y + z2;
+			z2 = cb2 * x - ca2 * y;
+			output[i] = y;
+		}
+
+		//avoid drifting away from the designed values
+		cb0 = hot.b0; cb1 = hot.b1; cb2 = hot.b2;
+		ca1 = hot.a1; ca2 = hot.a2;
+	}
+
+	hot.s1 = z1;
+	hot.s2 = z2;
+	hasTargets = false;
+	if(noDenormals.needsFlush()){
+		Denormals::flush(hot.s1);
+		Denormals::flush(hot.s2);
+	}
+}
+
+/**
+ * updateLookahead recomputes the block state-space matrices
+ * used by processBufferLookahead from the normalized
+ * coefficients.
+ * With the state s = (s1, s2) the filter is
+ *   y[n] = b0 x[n] + C s[n]
+ *   s[n+1] = A s[n] + B x[n]
+ * where A = [-a1 1; -a2 0], B = (b1 - a1 b0, b2 - a2 b0), C = (1 0).
+ * @see processBufferLookahead()
+ */
+void Biquad::updateLookahead(){
+	//rows C A^i
+	double r1 = 1, r2 = 0;
+	//columns A^m B
+	double c1 = hot.b1 - hot.a1 * hot.b0, c2 = hot.b2 - hot.a2 * hot.b0;
+	double h[4];
+	double col[4][2];
+
+	h[0] = hot.b0;
+	for(int i = 0; i < 4; i++){
+		laG[0][i] = r1;
+		laG[1][i] = r2;
+		col[i][0] = c1;
+		col[i][1] = c2;
+
+		//r = r A and c = A c
+		double t = r1;
+		r1 = -hot.a1 * r1 - hot.a2 * r2;
+		r2 = t;
+		t = c1;
+		c1 = -hot.a1 * c1 + c2;
+		c2 = -hot.a2 * t;
+	}
+	//impulse response, h[i] = C A^(i-1) B
+	for(int i = 1; i < 4; i++){
+		h[i] = laG[0][i-1] * col[0][0] + laG[1][i-1] * col[0][1];
+	}
+
+	for(int j = 0; j < 4; j++){
+		for(int i = 0; i < 4; i++){
+			laH[j][i] = i >= j ? h[i-j] : 0;
+		}
+		laK[j][0] = col[3-j][0];
+		laK[j][1] = col[3-j][1];
+	}
+
+	//A^4, from the columns A^4 e1 and A^4 e2
+	double p11 = 1, p21 = 0, p12 = 0, p22 = 1;
+	for(int i = 0; i < 4; i++){
+		double t1 = -hot.a1 * p11 + p21;
+		double t2 = -hot.a2 * p11;
+		p11 = t1; p21 = t2;
+		t1 = -hot.a1 * p12 + p22;
+		t2 = -hot.a2 * p12;
+		p12 = t1; p22 = t2;
+	}
+	laP[0][0] = p11;
+	laP[0][1] = p12;
+	laP[1][0] = p21;
+	laP[1][1] = p22;
+
+	lookaheadDirty = false;
+}
+
+/**
+ * processBufferLookahead applies the filter to a sample buffer
+ * four samples at a time. The recursion is unrolled into a
+ * state-space form in which the four outputs of a block only
+ * depend on the four inputs and on the state before the block,
+ * so they are computed with vector FMAs and the serial
+ * dependency is one state update per block instead of one per
+ * sample. It shares its state with processBufferTDF2 and gives
+ * the same result up to rounding.
+ * @param input A double array of size nFrames holding the intput signal
+ * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+ * @param nFrames The number of samples in the input and output buffer.
+ * @see processBufferTDF2()
+ */
+void Biquad::processBufferLookahead(double *input, double *output, int nFrames){
+	if(lookaheadDirty) updateLookahead();
+	ScopedNoDenormals noDenormals;
+
+	int nBlocks = nFrames / 4;
+	int i = 0;
+
+#if defined(__AVX__)
+	__m256d h0 = _mm256_loadu_pd(laH[0]), h1 = _mm256_loadu_pd(laH[1]);
+	__m256d h2 = _mm256_loadu_pd(laH[2]), h3 = _mm256_loadu_pd(laH[3]);
+	__m256d g1 = _mm256_loadu_pd(laG[0]), g2 = _mm256_loadu_pd(laG[1]);
+	__m128d k0 = _mm_loadu_pd(laK[0]), k1 = _mm_loadu_pd(laK[1]);
+	__m128d k2 = _mm_loadu_pd(laK[2]), k3 = _mm_loadu_pd(laK[3]);
+	__m128d p1 = _mm_set_pd(laP[1][0], laP[0][0]);
+	__m128d p2 = _mm_set_pd(laP[1][1], laP[0][1]);
+	__m128d s = _mm_set_pd(hot.s2, hot.s1);
+
+	for(int b = 0; b < nBlocks; b++, i += 4){
+		__m256d x0 = _mm256_broadcast_sd(input + i);
+		__m256d x1 = _mm256_broadcast_sd(input + i + 1);
+		__m256d x2 = _mm256_broadcast_sd(input + i + 2);
+		__m256d x3 = _mm256_broadcast_sd(input + i + 3);
+		__m256d z1 = _mm256_set1_pd(_mm_cvtsd_f64(s));
+		__m256d z2 = _mm256_set1_pd(_mm_cvtsd_f64(_mm_unpackhi_pd(s, s)));
+
+		__m256d y = _mm256_mul_pd(h0, x0);
+		y = _mm256_add_pd(y, _mm256_mul_pd(h1, x1));
+		y = _mm256_add_pd(y, _mm256_mul_pd(h2, x2));
+		y = _mm256_add_pd(y, _mm256_mul_pd(h3, x3));
+		y = _mm256_add_pd(y, _mm256_mul_pd(g1, z1));
+		y = _mm256_add_pd(y, _mm256_mul_pd(g2, z2));
+
+		__m128d ns = _mm_mul_pd(p1, _mm256_castpd256_pd128(z1));
+		ns = _mm_add_pd(ns, _mm_mul_pd(p2, _mm256_castpd256_pd128(z2)));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k0, _mm256_castpd256_pd128(x0)));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k1, _mm256_castpd256_pd128(x1)));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k2, _mm256_castpd256_pd128(x2)));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k3, _mm256_castpd256_pd128(x3)));
+		s = ns;
+
+		_mm256_storeu_pd(output + i, y);
+	}
+	hot.s1 = _mm_cvtsd_f64(s);
+	hot.s2 = _mm_cvtsd_f64(_mm_unpackhi_pd(s, s));
+#elif defined(__SSE2__) || defined(_M_X64)
+	//outputs 0-1 in the low vector and 2-3 in the high vector
+	__m128d h0l = _mm_loadu_pd(laH[0]), h0h = _mm_loadu_pd(laH[0] + 2);
+	__m128d h1l = _mm_loadu_pd(laH[1]), h1h = _mm_loadu_pd(laH[1] + 2);
+	__m128d h2h = _mm_loadu_pd(laH[2] + 2), h3h = _mm_loadu_pd(laH[3] + 2);
+	__m128d g1l = _mm_loadu_pd(laG[0]), g1h = _mm_loadu_pd(laG[0] + 2);
+	__m128d g2l = _mm_loadu_pd(laG[1]), g2h = _mm_loadu_pd(laG[1] + 2);
+	__m128d k0 = _mm_loadu_pd(laK[0]), k1 = _mm_loadu_pd(laK[1]);
+	__m128d k2 = _mm_loadu_pd(laK[2]), k3 = _mm_loadu_pd(laK[3]);
+	__m128d p1 = _mm_set_pd(laP[1][0], laP[0][0]);
+	__m128d p2 = _mm_set_pd(laP[1][1], laP[0][1]);
+	__m128d z1 = _mm_set1_pd(hot.s1);
+	__m128d z2 = _mm_set1_pd(hot.s2);
+
+	for(int b = 0; b < nBlocks; b++, i += 4){
+		__m128d x0 = _mm_set1_pd(input[i]);
+		__m128d x1 = _mm_set1_pd(input[i+1]);
+		__m128d x2 = _mm_set1_pd(input[i+2]);
+		__m128d x3 = _mm_set1_pd(input[i+3]);
+
+		//x2 and x3 do not reach outputs 0-1
+		__m128d yl = _mm_mul_pd(h0l, x0);
+		yl = _mm_add_pd(yl, _mm_mul_pd(h1l, x1));
+		yl = _mm_add_pd(yl, _mm_mul_pd(g1l, z1));
+		yl = _mm_add_pd(yl, _mm_mul_pd(g2l, z2));
+
+		__m128d yh = _mm_mul_pd(h0h, x0);
+		yh = _mm_add_pd(yh, _mm_mul_pd(h1h, x1));
+		yh = _mm_add_pd(yh, _mm_mul_pd(h2h, x2));
+		yh = _mm_add_pd(yh, _mm_mul_pd(h3h, x3));
+		yh = _mm_add_pd(yh, _mm_mul_pd(g1h, z1));
+		yh = _mm_add_pd(yh, _mm_mul_pd(g2h, z2));
+
+		__m128d ns = _mm_mul_pd(p1, z1);
+		ns = _mm_add_pd(ns, _mm_mul_pd(p2, z2));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k0, x0));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k1, x1));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k2, x2));
+		ns = _mm_add_pd(ns, _mm_mul_pd(k3, x3));
+		z1 = _mm_unpacklo_pd(ns, ns);
+		z2 = _mm_unpackhi_pd(ns, ns);
+
+		_mm_storeu_pd(output + i, yl);
+		_mm_storeu_pd(output + i + 2, yh);
+	}
+	hot.s1 = _mm_cvtsd_f64(z1);
+	hot.s2 = _mm_cvtsd_f64(z2);
+#else
+	for(int b = 0; b < nBlocks; b++, i += 4){
+		double x[4] = {input[i], input[i+1], input[i+2], input[i+3]};
+		for(int k = 0; k < 4; k++){
+			output[i+k] = laH[0][k] * x[0] + laH[1][k] * x[1] + laH[2][k] * x[2]
+				+ laH[3][k] * x[3] + laG[0][k] * hot.s1 + laG[1][k] * hot.s2;
+		}
+		double n1 = laP[0][0] * hot.s1 + laP[0][1] * hot.s2;
+		double n2 = laP[1][0] * hot.s1 + laP[1][1] * hot.s2;
+		for(int k = 0; k < 4; k++){
+			n1 += laK[k][0] * x[k];
+			n2 += laK[k][1] * x[k];
+		}
+		hot.s1 = n1;
+		hot.s2 = n2;
+	}
+#endif
+
+	//remaining samples, also flushes the state if needed
+	processBufferTDF2(input + i, output + i, nFrames - i);
+}
+
+/**
+ * processBufferParallel is an offline version of
+ * processBufferTDF2 that splits the buffer into one chunk per
+ * thread. Every chunk is filtered from a zero state in
+ * parallel, then the state at the start of each chunk is
+ * propagated through the chunks and its zero-input response
+ * is added to the chunk, again in parallel. By superposition
+ * the result equals the serial output up to rounding. Not for
+ * use on the audio thread.
+ * @param input A double array of size nFrames holding the intput signal
+ * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+ * @param nFrames The number of samples in the input and output buffer.
+ * @param nThreads The number of threads to use
+ * @see processBufferTDF2()
+ */
+void Biquad::processBufferParallel(double *input, double *output, int nFrames, int nThreads){
+	if(nThreads > nFrames / PARALLEL_MIN_CHUNK) nThreads = nFrames / PARALLEL_MIN_CHUNK;
+	if(nThreads < 2){
+		processBufferTDF2(input, output, nFrames);
+		return;
+	}
+
+	int len = (nFrames + nThreads - 1) / nThreads;
+	int nChunks = (nFrames + len - 1) / len;
+	double cb0 = hot.b0, cb1 = hot.b1, cb2 = hot.b2;
+	double ca1 = hot.a1, ca2 = hot.a2;
+
+	//state at the start and at the end of each chunk
+	std::vector<double> start1(nChunks), start2(nChunks);
+	std::vector<double> end1(nChunks), end2(nChunks);
+	std::vector<std::thread> threads;
+
+	//pass 1: filter every chunk from a zero state. The first chunk
+	//starts from the real state and needs no correction.
+	start1[0] = hot.s1;
+	start2[0] = hot.s2;
+	for(int k = 0; k < nChunks; k++){
+		threads.push_back(std::thread([=, &end1, &end2](){
+			//the floating point mode is per thread
+			ScopedNoDenormals noDenormals;
+			int from = k * len;
+			int n = nFrames - from < len ? nFrames - from : len;
+			double z1 = k == 0 ? hot.s1 : 0;
+			double z2 = k == 0 ? hot.s2 : 0;
+			for(int i = from; i < from + n; i++){
+				double x = input[i];
+				double y = cb0 * x + z1;
+				z1 = cb1 * x - ca1 * y + z2;
+				z2 = cb2 * x - ca2 * y;
+				output[i] = y;
+			}
+			end1[k] = z1;
+			end2[k] = z2;
+		}));
+	}
+	for(int k = 0; k < nChunks; k++) threads[k].join();
+	threads.clear();
+
+	//transition matrix of the zero-input recursion over len samples
+	//A = [-a1 1; -a2 0], computed by repeated squaring
+	double p11 = 1, p12 = 0, p21 = 0, p22 = 1;
+	double m11 = -ca1, m12 = 1, m21 = -ca2, m22 = 0;
+	for(int e = len; e > 0; e >>= 1){
+		double t11, t12, t21, t22;
+		if(e & 1){
+			t11 = m11 * p11 + m12 * p21;
+			t12 = m11 * p12 + m12 * p22;
+			t21 = m21 * p11 + m22 * p21;
+			t22 = m21 * p12 + m22 * p22;
+			p11 = t11; p12 = t12; p21 = t21; p22 = t22;
+		}
+		t11 = m11 * m11 + m12 * m21;
+		t12 = m11 * m12 + m12 * m22;
+		t21 = m21 * m11 + m22 * m21;
+		t22 = m21 * m12 + m22 * m22;
+		m11 = t11; m12 = t12; m21 = t21; m22 = t22;
+	}
+
+	//pass 2: propagate the true state through the chunks
+	for(int k = 1; k < nChunks; k++){
+		double z1 = k == 1 ? 0 : start1[k-1];
+		double z2 = k == 1 ? 0 : start2[k-1];
+		start1[k] = end1[k-1] + p11 * z1 + p12 * z2;
+		start2[k] = end2[k-1] + p21 * z1 + p22 * z2;
+	}
+
+	//pass 3: add the zero-input response of the starting state
+	std::vector<double> corr1(nChunks, 0), corr2(nChunks, 0);
+	for(int k = 1; k < nChunks; k++){
+		threads.push_back(std::thread([=, &start1, &start2, &corr1, &corr2](){
+			ScopedNoDenormals noDenormals;
+			int from = k * len;
+			int n = nFrames - from < len ? nFrames - from : len;
+			double z1 = start1[k];
+			double z2 = start2[k];
+			//stop once the response is far below the rounding error
+			//so that the tail does not decay into denormals
+			double floor = 1e-18 * (fabs(z1) + fabs(z2));
+			for(int i = from; i < from + n; i++){
+				double y = z1;
+				z1 = z2 - ca1 * y;
+				z2 = -ca2 * y;
+				output[i] += y;
+				if(fabs(z1) + fabs(z2) <= floor){
+					z1 = 0;
+					z2 = 0;
+					break;
+				}
+			}
+			corr1[k] = z1;
+			corr2[k] = z2;
+		}));
+	}
+	for(size_t k = 0; k < threads.size(); k++) threads[k].join();
+
+	hot.s1 = end1[nChunks-1] + corr1[nChunks-1];
+	hot.s2 = end2[nChunks-1] + corr2[nChunks-1];
+	if(Denormals::isEnabled()){
+		Denormals::flush(hot.s1);
+		Denormals::flush(hot.s2);
+	}
+}
+
 /**
  * updateXs is used to update the x values in the history.
  * @param x The current value of x to be used for processing (x0).
@@ -731,17 +1313,16 @@ void Biquad::updateYs(double y){
 }
 
 /**
- * processBuffer applied the filter to a sample buffer
+ * processBuffer applied the filter to a sample buffer. Only the
+ * hot BiquadKernel is touched: this is processBufferTDF2. The
+ * history of the per sample interface is not used.
  * @param input A double array of size nFrames holding the intput signal
  * @param output A double buffer of size nFrames for a pass by call output
  * @param nFrames The number of samples in the input and output buffer.
+ * @see processBufferTDF2()
  */
 void Biquad::processBuffer(double *input, double *output, int nFrames){
-	for(int i = 0; i < nFrames; i++){
-		updateXs(input[i]);
-		output[i] = generateOutputSample();
-		updateYs(output[i]);
-	}
+	processBufferTDF2(input, output, nFrames);
 }
 
 /**
@@ -772,6 +1353,14 @@ void Biquad::getCoFs(double *as, double *bs){
 	getAs(as);
 	getBs(bs);
 }
+void Biquad::getNormCoFs(double *as, double *bs){
+	as[0] = 1;
+	as[1] = hot.a1;
+	as[2] = hot.a2;
+	bs[0] = hot.b0;
+	bs[1] = hot.b1;
+	bs[2] = hot.b2;
+}
 void Biquad::getXHist(double *xs){
 	 xs[0] = x0;
 	 xs[1] = x1;
@@ -785,3 +1374,173 @@ void Biquad::getHist(double *xs, double *ys){
 	 getXHist(xs);
 	 getYHist(ys);
 }
+void Biquad::getState(double *ss){
+	 ss[0] = hot.s1;
+	 ss[1] = hot.s2;
+}
+/**
+ * processBuffer applies the filter while its center/cutoff
+ * frequency follows fcMod at audio rate. The switch on the mode
+ * is done once per buffer.
+ * @param input A double array of size nFrames holding the intput signal
+ * @param fcMod A double array of size nFrames holding the frequency in Hz for each sample
+ * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+ * @param nFrames The number of samples in the buffers
+ * @see processModulated()
+ */
+void Biquad::processBuffer(double *input, double *fcMod, double *output, int nFrames){
+	if(nFrames <= 0) return;
+	bool oct = (BWMode == 1);
+	switch(mode){
+	case 1:
+		if(oct) processModulated<LowPass, true>(input, fcMod, output, nFrames);
+		else processModulated<LowPass, false>(input, fcMod, output, nFrames);
+		break;
+	case 2:
+		if(oct) processModulated<HighPass, true>(input, fcMod, output, nFrames);
+		else processModulated<HighPass, false>(input, fcMod, output, nFrames);
+		break;
+	case 3:
+		if(oct) processModulated<Notch, true>(input, fcMod, output, nFrames);
+		else processModulated<Notch, false>(input, fcMod, output, nFrames);
+		break;
+	case 4:
+		if(oct) processModulated<AllPass, true>(input, fcMod, output, nFrames);
+		else processModulated<AllPass, false>(input, fcMod, output, nFrames);
+		break;
+	case 5:
+		if(oct) processModulated<LowShelf, true>(input, fcMod, output, nFrames);
+		else processModulated<LowShelf, false>(input, fcMod, output, nFrames);
+		break;
+	case 6:
+		if(oct) processModulated<HighShelf, true>(input, fcMod, output, nFrames);
+		else processModulated<HighShelf, false>(input, fcMod, output, nFrames);
+		break;
+	case 0:
+	default:
+		if(oct) processModulated<BandPass, true>(input, fcMod, output, nFrames);
+		else processModulated<BandPass, false>(input, fcMod, output, nFrames);
+	}
+}
+
+/**
+ * processModulated is the inner loop of the modulated
+ * processBuffer for the mode M. Everything that does not depend
+ * on fc (gain, the Q or slope factor of alpha) is computed once.
+ * @see processBuffer(double*, double*, double*, int)
+ */
+template<unsigned int M, bool OCT>
+void Biquad::processModulated(double *input, double *fcMod, double *output, int nFrames){
+	ScopedNoDenormals noDenormals;
+
+	updateGain();
+	double g = isShelf<M>() ? gain : 1;
+	double twoSqrtG = 2 * sqrt(g);
+	//alpha = sinW0 * k for the Q and slope bandwidths
+	double k = 0;
+	if(!OCT){
+		if(BWMode == 2) k = 0.5 * sqrt( (g+1/g)*(1/slope-1)+2 );
+		else k = 1 / (2 * Q);
+	}
+	double octK = (LN2) / 2 * BW;
+
+	double w = 2 * M_PI / Fs;
+	double fMin = MOD_MIN_FC * Fs, fMax = MOD_MAX_FC * Fs;
+	double f = fc;
+	double z1 = hot.s1, z2 = hot.s2;
+	double as[3];
+	double bs[3];
+
+	for(int i = 0; i < nFrames; i++){
+		f = fcMod[i];
+		if(f < fMin) f = fMin;
+		if(f > fMax) f = fMax;
+
+		double w0 = w * f;
+		double c = fastCos(w0);
+		double sn = fastSin(w0);
+		double a;
+		if(OCT) a = sn * fastSinh(octK * w0 / sn);
+		else a = sn * k;
+		biquadCoFs<M>(c, a, twoSqrtG * a, g, bs, as);
+		double inv = 1 / as[0];
+
+		double x = input[i];
+		double y = bs[0] * inv * x + z1;
+		z1 = (bs[1] * x - as[1] * y) * inv + z2;
+		z2 = (bs[2] * x - as[2] * y) * inv;
+		output[i] = y;
+	}
+
+	hot.s1 = z1;
+	hot.s2 = z2;
+	if(noDenormals.needsFlush()){
+		Denormals::flush(hot.s1);
+		Denormals::flush(hot.s2);
+	}
+
+	//leave the filter designed for the last frequency
+	fc = f;
+	redesign();
+}
+
+/**
+ * applyEvent stores the value of one event without updating
+ * the coefficients.
+ * @param ev The event
+ * @return true IFF the event changed a parameter
+ */
+bool Biquad::applyEvent(const ParameterEvent &ev){
+	switch(ev.param){
+	case FC_PARAM:
+		if(ev.value <= 0) return false;
+		fc = ev.value;
+		return true;
+	case BW_PARAM:
+		if(ev.value <= 0) return false;
+		setBWParam(ev.value);
+		return true;
+	case GAIN_PARAM:
+		dBG = ev.value;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * processEvents is the core of the event list processBuffer. All
+ * the events sharing an offset are applied before a single
+ * redesign.
+ * @see splitAtEvents()
+ * @see processBuffer(double*, double*, int, const ParameterEvent*, int)
+ */
+template<typename T>
+void Biquad::processEvents(T *input, T *output, int nFrames, const ParameterEvent *events, int nEvents){
+	splitAtEvents(events, nEvents, nFrames,
+		[this](const ParameterEvent &ev){return applyEvent(ev);},
+		[this](){redesign();},
+		[this, input, output](int pos, int n){processBufferTDF2(input + pos, output + pos, n);});
+}
+
+/**
+ * processBuffer applies the filter while applying the parameter
+ * changes of an event list at their sample offsets.
+ * @param input A double array of size nFrames holding the intput signal
+ * @param output A double buffer of size nFrames. May be the same as input.
+ * @param nFrames The number of samples in the buffers
+ * @param events The events, sorted by offset
+ * @param nEvents The number of events
+ * @see ParameterEvent
+ */
+void Biquad::processBuffer(double *input, double *output, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, output, nFrames, events, nEvents);
+}
+
+/**
+ * Float version of the event list processBuffer
+ * @see processBuffer(double*, double*, int, const ParameterEvent*, int)
+ */
+void Biquad::processBuffer(float *input, float *output, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, output, nFrames, events, nEvents);
+}
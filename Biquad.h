@@ -2,13 +2,73 @@
 #define BIQUAD_H
 
 #include <cmath>
+#include "Denormals.h"
+#include "ParameterEvent.h"
 
 //global paramters
 #define M_PI 3.14159265358
 #define LN2 0.69314718056
 
+//range of the audio rate modulated frequency, relative to Fs
+#define MOD_MIN_FC 1e-5
+#define MOD_MAX_FC 0.49
+
+struct BiquadDesignKey;
+
+/**
+ * BiquadKernel holds the only data touched per sample by the
+ * block processing paths: the coefficients normalized by a0 and
+ * the transposed direct form II state. It fills exactly one
+ * cache line so that running hundreds of filters only streams
+ * one line per filter through the cache. Filters created with
+ * new are only guaranteed this alignment with C++17 aligned new
+ * (-faligned-new); otherwise the kernel may straddle two lines.
+ */
+struct alignas(64) BiquadKernel{
+	double b0, b1, b2;
+	double a1, a2;
+	double s1, s2;
+};
+
+/**
+ * processKernel applies the filter held by a BiquadKernel to a
+ * sample buffer using the transposed direct form II. The state is
+ * kept in locals for the whole buffer and written back at the end.
+ * Shared by Biquad and the compile time specialized StaticBiquad.
+ * @param k The coefficients and state of the filter
+ * @param input A T array of size nFrames holding the intput signal
+ * @param output A T buffer of size nFrames. May be the same as input.
+ * @param nFrames The number of samples in the input and output buffer.
+ */
+template<typename T>
+inline void processKernel(BiquadKernel &k, T *input, T *output, int nFrames){
+	ScopedNoDenormals noDenormals;
+	T cb0 = (T)k.b0, cb1 = (T)k.b1, cb2 = (T)k.b2;
+	T ca1 = (T)k.a1, ca2 = (T)k.a2;
+	T z1 = (T)k.s1, z2 = (T)k.s2;
+
+	for(int i = 0; i < nFrames; i++){
+		T x = input[i];
+		T y = cb0 * x + z1;
+		z1 = cb1 * x - ca1 * y + z2;
+		z2 = cb2 * x - ca2 * y;
+		output[i] = y;
+	}
+
+	k.s1 = z1;
+	k.s2 = z2;
+	if(noDenormals.needsFlush()){
+		Denormals::flush(k.s1);
+		Denormals::flush(k.s2);
+	}
+}
+
 class Biquad{
 protected:
+	//hot data, first so that it starts the object
+	BiquadKernel hot;
+
+	/******** cold data, only used to design the filter ********/
 	/* The mode parameter is used to change the mode of operation
 	 * of the biqaud filter.
 	 * 0: Band-Pass Filter
@@ -45,10 +105,27 @@ protected:
 	double a1;
 	double a2;
 
-	//delay lines
+	//delay lines of the per sample interface
+	//updateXs(), generateOutputSample() and updateYs()
 	double x0, x1, x2;
 	double y1, y2;
 
+	//parameter smoothing
+	int smoothInterval;					//samples between two designs, 0 if off
+	bool hasTargets;					//true IFF targets are pending
+	double fcTarget;
+	double bwTarget;					//Q, BW or slope depending on BWMode
+	double dBGTarget;
+
+	bool fastMath;						//true IFF the design uses FastMath
+
+	//4 sample lookahead matrices for processBufferLookahead
+	bool lookaheadDirty;				//true IFF the matrices are out of date
+	double laH[4][4];					//column j: response of the block to x[j]
+	double laG[2][4];					//row k: response of the block to state k
+	double laK[4][2];					//row j: new state due to x[j]
+	double laP[2][2];					//new state due to the old state, A^4
+
 public:
 	/**
 	 * Creates a filter with all parameters initialized to 0
@@ -260,6 +337,14 @@ public:
 	 */
 	void updateCoFs();
 
+	/**
+	 * normalizeCoFs divides the coefficients by a0 and stores
+	 * them for use by processBufferTDF2. Called by updateCoFs.
+	 * @see updateCoFs()
+	 * @see processBufferTDF2()
+	 */
+	void normalizeCoFs();
+
 	/**
 	 * updateBs changes the values of b coefficiens. Not optimized for
 	 * shelving filters. Use update Cofs instead in these cases.
@@ -341,6 +426,121 @@ public:
 	 */
 	void updateA2();
 
+	/**
+	 * getDesignKey fills in the parameters identifying the
+	 * current design in BiquadCache.
+	 * @param k Pass by call key
+	 * @see BiquadCache
+	 */
+	void getDesignKey(BiquadDesignKey &k);
+
+	/**
+	 * loadCachedDesign copies the design matching the current
+	 * parameters from BiquadCache, if the cache is enabled.
+	 * @see BiquadCache
+	 * @return true IFF the design was loaded
+	 */
+	bool loadCachedDesign();
+
+	/**
+	 * storeCachedDesign adds the current design to BiquadCache,
+	 * if the cache is enabled.
+	 * @see BiquadCache
+	 */
+	void storeCachedDesign();
+
+	/**
+	 * updateLookahead recomputes the block state-space matrices
+	 * used by processBufferLookahead from the normalized
+	 * coefficients.
+	 * @see processBufferLookahead()
+	 */
+	void updateLookahead();
+
+	/**
+	 * redesign recomputes every intermediate parameter and the
+	 * coefficients from the user parameters.
+	 * @see updateOmega()
+	 * @see updateGain()
+	 * @see updateAlpha()
+	 * @see updateAlphaPrime()
+	 * @see updateCoFs()
+	 */
+	void redesign();
+
+	/**
+	 * processModulated is the inner loop of the modulated
+	 * processBuffer for the mode M. OCT is true for the octave
+	 * bandwidth, whose alpha is not proportional to sinW0.
+	 * @see processBuffer(double*, double*, double*, int)
+	 */
+	template<unsigned int M, bool OCT>
+	void processModulated(double *input, double *fcMod, double *output, int nFrames);
+
+	/**
+	 * applyEvent stores the value of one event without updating
+	 * the coefficients.
+	 * @param ev The event
+	 * @return true IFF the event changed a parameter
+	 */
+	bool applyEvent(const ParameterEvent &ev);
+
+	/**
+	 * processEvents is the core of the event list processBuffer.
+	 * @see processBuffer(double*, double*, int, const ParameterEvent*, int)
+	 */
+	template<typename T>
+	void processEvents(T *input, T *output, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * getBWParam returns the bandwidth parameter used by the
+	 * current BWMode.
+	 * @return Q if BWMode is 0; BW if BWMode is 1; slope if BWMode is 2
+	 */
+	double getBWParam();
+
+	/**
+	 * setBWParam sets the bandwidth parameter used by the current
+	 * BWMode without updating any dependant parameter.
+	 * @param b Q if BWMode is 0; BW if BWMode is 1; slope if BWMode is 2
+	 */
+	void setBWParam(double b);
+
+	/**
+	 * setFastMath selects the polynomial approximations of FastMath
+	 * instead of libm for the design of the filter. The filter is
+	 * redesigned with the new setting.
+	 * @param f IFF true the design uses FastMath
+	 * @see FastMath.h
+	 */
+	void setFastMath(bool f);
+
+	bool getFastMath(){return fastMath;}
+
+	/**
+	 * setSmoothing enables parameter smoothing for
+	 * processBufferSmoothed. The filter is redesigned every
+	 * interval samples and the normalized coefficients are
+	 * linearly interpolated in between. Typical values are 16
+	 * to 64 samples.
+	 * @param interval The number of samples between two designs. 0 disables smoothing.
+	 * @return true IFF interval is valid
+	 */
+	bool setSmoothing(int interval);
+
+	int getSmoothing(){return smoothInterval;}
+
+	/**
+	 * setTargets gives the parameters that should be reached at
+	 * the end of the next call to processBufferSmoothed. The
+	 * parameters glide linearly from their current values.
+	 * @param f The target center frequency
+	 * @param b The target Q, BW or slope depending on BWMode
+	 * @param dbg The target gain in dB. Only used by shelving filters.
+	 * @see processBufferSmoothed()
+	 */
+	void setTargets(double f, double b, double dbg);
+
 	/**
 	 * updateXs is used to update the x values in the history.
 	 * @param x The current value of x to be used for processing (x0).
@@ -359,10 +559,13 @@ public:
 	void updateYs(double y);
 
 	/**
-	 * processBuffer applied the filter to a sample buffer
+	 * processBuffer applied the filter to a sample buffer. Only the
+	 * hot BiquadKernel is touched: this is processBufferTDF2. The
+	 * history of the per sample interface is not used.
 	 * @param input A double array of size nFrames holding the intput signal
 	 * @param output A double buffer of size nFrames for a pass by call output
 	 * @param nFrames The number of samples in the input and output buffer.
+	 * @see processBufferTDF2()
 	 */
 	void processBuffer(double *input, double *output, int nFrames);
 
@@ -373,6 +576,136 @@ public:
 	 */
 	double generateOutputSample();
 
+	/**
+	 * processBufferTDF2 applies the filter to a sample buffer using
+	 * the transposed direct form II with the coefficients
+	 * normalized by updateCoFs. The state is kept in locals for
+	 * the whole buffer, so there is no division nor history
+	 * shifting per sample. Its state is separate from the history
+	 * of the per sample interface (updateXs, generateOutputSample
+	 * and updateYs).
+	 * The coefficients are designed in double precision and the
+	 * arithmetic is done in the sample type T (double or float).
+	 * The float path is stable but loses precision for cutoffs
+	 * far below Fs/1000; use double buffers there.
+	 * @param input A T array of size nFrames holding the intput signal
+	 * @param output A T buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the input and output buffer.
+	 * @see normalizeCoFs()
+	 */
+	template<typename T>
+	inline void processBufferTDF2(T *input, T *output, int nFrames){
+		processKernel(hot, input, output, nFrames);
+	}
+
+	/**
+	 * processBufferSmoothed applies the filter while the
+	 * parameters glide toward the values given to setTargets.
+	 * The design runs once every smoothing interval and the
+	 * normalized coefficients are interpolated per sample, which
+	 * avoids zipper noise without a full design per sample. If
+	 * smoothing is off or no targets are pending it behaves
+	 * like processBufferTDF2.
+	 * @param input A double array of size nFrames holding the intput signal
+	 * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the input and output buffer.
+	 * @see setSmoothing()
+	 * @see setTargets()
+	 */
+	void processBufferSmoothed(double *input, double *output, int nFrames);
+
+	/**
+	 * processBufferLookahead applies the filter to a sample buffer
+	 * four samples at a time. The recursion is unrolled into a
+	 * state-space form in which the four outputs of a block only
+	 * depend on the four inputs and on the state before the block,
+	 * so they are computed with vector FMAs and the serial
+	 * dependency is one state update per block instead of one per
+	 * sample. It shares its state with processBufferTDF2 and gives
+	 * the same result up to rounding.
+	 * @param input A double array of size nFrames holding the intput signal
+	 * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the input and output buffer.
+	 * @see processBufferTDF2()
+	 */
+	void processBufferLookahead(double *input, double *output, int nFrames);
+
+	/**
+	 * processBufferParallel is an offline version of
+	 * processBufferTDF2 that splits the buffer into one chunk per
+	 * thread. Every chunk is filtered from a zero state in
+	 * parallel, then the state at the start of each chunk is
+	 * propagated through the chunks and its zero-input response
+	 * is added to the chunk, again in parallel. By superposition
+	 * the result equals the serial output up to rounding. Not for
+	 * use on the audio thread.
+	 * @param input A double array of size nFrames holding the intput signal
+	 * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the input and output buffer.
+	 * @param nThreads The number of threads to use
+	 * @see processBufferTDF2()
+	 */
+	void processBufferParallel(double *input, double *output, int nFrames, int nThreads);
+
+	/**
+	 * processBuffer applies the filter while its center/cutoff
+	 * frequency follows fcMod at audio rate. The coefficients are
+	 * designed for every sample with the FastMath sin/cos (and
+	 * sinh for the octave bandwidth), using the current Q, BW or
+	 * slope and dB gain. Each fcMod value is clamped to
+	 * [MOD_MIN_FC, MOD_MAX_FC] * Fs, where the approximated cos
+	 * stays below 1 and alpha above 0, so every per sample design
+	 * has its poles inside the unit circle. At the end fc is set
+	 * to the last clamped value and the filter is redesigned.
+	 * @param input A double array of size nFrames holding the intput signal
+	 * @param fcMod A double array of size nFrames holding the frequency in Hz for each sample
+	 * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the buffers
+	 * @see processModulated()
+	 */
+	void processBuffer(double *input, double *fcMod, double *output, int nFrames);
+
+	/**
+	 * Parameter ids of the events given to processBuffer.
+	 * FC_PARAM: center/cutoff frequency in Hz
+	 * BW_PARAM: Q, BW or slope following BWMode
+	 * GAIN_PARAM: gain in dB
+	 */
+	enum{FC_PARAM = 0, BW_PARAM = 1, GAIN_PARAM = 2};
+
+	/**
+	 * processBuffer applies the filter while applying the
+	 * parameter changes of an event list at their sample offsets.
+	 * The buffer is split at the offsets, every sub-block is run
+	 * with processBufferTDF2 and the filter is redesigned once
+	 * between sub-blocks, so there is no per sample branching.
+	 * @param input A double array of size nFrames holding the intput signal
+	 * @param output A double buffer of size nFrames. May be the same as input.
+	 * @param nFrames The number of samples in the buffers
+	 * @param events The events, sorted by offset
+	 * @param nEvents The number of events
+	 * @see ParameterEvent
+	 */
+	void processBuffer(double *input, double *output, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * Float version of the event list processBuffer
+	 * @see processBuffer(double*, double*, int, const ParameterEvent*, int)
+	 */
+	void processBuffer(float *input, float *output, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * processBuffer applies the filter to a float32 sample buffer
+	 * using float arithmetic and state.
+	 * @param input A float array of size nFrames holding the intput signal
+	 * @param output A float buffer of size nFrames for a pass by call output
+	 * @param nFrames The number of samples in the input and output buffer.
+	 * @see processBufferTDF2()
+	 */
+	void processBuffer(float *input, float *output, int nFrames){
+		processBufferTDF2(input, output, nFrames);
+	}
+
 	unsigned int getMode(){return mode;}
 	double getFs(){return Fs;}
 	double getFc(){return fc;}
@@ -386,8 +719,10 @@ public:
 	void getBs(double *bs);
 	void getAs(double *as);
 	void getCoFs(double *as, double *bs);
+	void getNormCoFs(double *as, double *bs);
 	 void getXHist(double *xs);
 	 void getYHist(double *ys);
 	 void getHist(double *xs, double *ys);
+	 void getState(double *ss);
 };
 #endif
\ No newline at end of file
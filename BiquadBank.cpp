@@ -0,0 +1,242 @@
+#include "BiquadBank.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Creates a bank of n filters all using the same mode. Every
+ * lane passes its input through unchanged until its
+ * parameters are set.
+ * @param n The number of filters in the bank
+ * @param m The mode of the filters. See Biquad
+ * @param bwm The bandwidth mode of the filters. See Biquad
+ */
+BiquadBank::BiquadBank(int n, unsigned int m, unsigned int bwm){
+	nLanes = n;
+	designers = new Biquad*[nLanes];
+
+	//one block for all the SoA arrays
+	b0 = new double[7 * nLanes];
+	b1 = b0 + nLanes;
+	b2 = b1 + nLanes;
+	a1 = b2 + nLanes;
+	a2 = a1 + nLanes;
+	s1 = a2 + nLanes;
+	s2 = s1 + nLanes;
+
+	for(int i = 0; i < nLanes; i++){
+		designers[i] = new Biquad(m, bwm);
+		b0[i] = 1;
+		b1[i] = 0;
+		b2[i] = 0;
+		a1[i] = 0;
+		a2[i] = 0;
+	}
+	initHist();
+}
+
+BiquadBank::~BiquadBank(){
+	for(int i = 0; i < nLanes; i++) delete designers[i];
+	delete[] designers;
+	delete[] b0;
+}
+
+/**
+ * loadCoFs copies the normalized coefficients of a lane's
+ * designer into the bank.
+ * @param lane The lane to update
+ */
+void BiquadBank::loadCoFs(int lane){
+	double as[3];
+	double bs[3];
+	designers[lane]->getNormCoFs(as, bs);
+
+	b0[lane] = bs[0];
+	b1[lane] = bs[1];
+	b2[lane] = bs[2];
+	a1[lane] = as[1];
+	a2[lane] = as[2];
+}
+
+/**
+ * setMode changes the mode of a single lane. The parameters of
+ * the lane must be set again afterwards.
+ * @param lane The lane to change
+ * @param m The mode of the filter. See Biquad
+ * @param bwm The bandwidth mode of the filter. See Biquad
+ * @return true IFF lane is a valid lane
+ */
+bool BiquadBank::setMode(int lane, unsigned int m, unsigned int bwm){
+	if(lane < 0 || lane >= nLanes) return false;
+	delete designers[lane];
+	designers[lane] = new Biquad(m, bwm);
+	return true;
+}
+
+/**
+ * Per lane equivalent of Biquad::setParamsQ()
+ * @param lane The lane to update
+ * @return true IFF lane is a valid lane
+ * @see Biquad::setParamsQ()
+ */
+bool BiquadBank::setParamsQ(int lane, double fs, double f, double q){
+	if(lane < 0 || lane >= nLanes) return false;
+	designers[lane]->setParamsQ(fs, f, q);
+	loadCoFs(lane);
+	return true;
+}
+
+/**
+ * Per lane equivalent of Biquad::setParamsBW()
+ * @param lane The lane to update
+ * @return true IFF the lane was updated
+ * @see Biquad::setParamsBW()
+ */
+bool BiquadBank::setParamsBW(int lane, double fs, double f, double b){
+	if(lane < 0 || lane >= nLanes) return false;
+	if(!designers[lane]->setParamsBW(fs, f, b)) return false;
+	loadCoFs(lane);
+	return true;
+}
+
+/**
+ * Per lane equivalent of Biquad::setParamsSlope()
+ * @param lane The lane to update
+ * @return true IFF the lane was updated
+ * @see Biquad::setParamsSlope()
+ */
+bool BiquadBank::setParamsSlope(int lane, double fs, double f, double s, double dbg){
+	if(lane < 0 || lane >= nLanes) return false;
+	if(!designers[lane]->setParamsSlope(fs, f, s, dbg)) return false;
+	loadCoFs(lane);
+	return true;
+}
+
+/**
+ * initHist clears the history of every lane
+ */
+void BiquadBank::initHist(){
+	for(int i = 0; i < nLanes; i++){
+		s1[i] = 0;
+		s2[i] = 0;
+	}
+}
+
+/**
+ * processBuffer applies every filter of the bank to its own
+ * channel. Lane i reads input[i] and writes output[i].
+ * @param input Array of nLanes input buffers of size nFrames
+ * @param output Array of nLanes output buffers of size nFrames
+ * @param nFrames The number of samples in each buffer
+ */
+void BiquadBank::processBuffer(double **input, double **output, int nFrames){
+	ScopedNoDenormals noDenormals;
+	int l = 0;
+	//full vectors
+	for(; l + BANK_WIDTH <= nLanes && BANK_WIDTH > 1; l += BANK_WIDTH){
+		processGroup(l, input, output, nFrames);
+	}
+	//remaining lanes
+	for(; l < nLanes; l++){
+		processLane(l, input[l], output[l], nFrames);
+	}
+
+	if(noDenormals.needsFlush()){
+		for(l = 0; l < nLanes; l++){
+			Denormals::flush(s1[l]);
+			Denormals::flush(s2[l]);
+		}
+	}
+}
+
+/**
+ * processGroup filters BANK_WIDTH consecutive lanes with
+ * vector instructions.
+ * @param g The first lane of the group
+ * @param input Array of nLanes input buffers
+ * @param output Array of nLanes output buffers
+ * @param nFrames The number of samples in each buffer
+ */
+void BiquadBank::processGroup(int g, double **input, double **output, int nFrames){
+#if defined(__AVX__)
+	double *in0 = input[g], *in1 = input[g+1], *in2 = input[g+2], *in3 = input[g+3];
+	double *out0 = output[g], *out1 = output[g+1], *out2 = output[g+2], *out3 = output[g+3];
+	__m256d vb0 = _mm256_loadu_pd(b0 + g);
+	__m256d vb1 = _mm256_loadu_pd(b1 + g);
+	__m256d vb2 = _mm256_loadu_pd(b2 + g);
+	__m256d va1 = _mm256_loadu_pd(a1 + g);
+	__m256d va2 = _mm256_loadu_pd(a2 + g);
+	__m256d vs1 = _mm256_loadu_pd(s1 + g);
+	__m256d vs2 = _mm256_loadu_pd(s2 + g);
+	double y[4];
+
+	for(int i = 0; i < nFrames; i++){
+		__m256d x = _mm256_set_pd(in3[i], in2[i], in1[i], in0[i]);
+		__m256d vy = _mm256_add_pd(_mm256_mul_pd(vb0, x), vs1);
+		vs1 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(vb1, x), _mm256_mul_pd(va1, vy)), vs2);
+		vs2 = _mm256_sub_pd(_mm256_mul_pd(vb2, x), _mm256_mul_pd(va2, vy));
+		_mm256_storeu_pd(y, vy);
+		out0[i] = y[0];
+		out1[i] = y[1];
+		out2[i] = y[2];
+		out3[i] = y[3];
+	}
+
+	_mm256_storeu_pd(s1 + g, vs1);
+	_mm256_storeu_pd(s2 + g, vs2);
+#elif defined(__SSE2__) || defined(_M_X64)
+	double *in0 = input[g], *in1 = input[g+1];
+	double *out0 = output[g], *out1 = output[g+1];
+	__m128d vb0 = _mm_loadu_pd(b0 + g);
+	__m128d vb1 = _mm_loadu_pd(b1 + g);
+	__m128d vb2 = _mm_loadu_pd(b2 + g);
+	__m128d va1 = _mm_loadu_pd(a1 + g);
+	__m128d va2 = _mm_loadu_pd(a2 + g);
+	__m128d vs1 = _mm_loadu_pd(s1 + g);
+	__m128d vs2 = _mm_loadu_pd(s2 + g);
+
+	for(int i = 0; i < nFrames; i++){
+		__m128d x = _mm_set_pd(in1[i], in0[i]);
+		__m128d vy = _mm_add_pd(_mm_mul_pd(vb0, x), vs1);
+		vs1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(vb1, x), _mm_mul_pd(va1, vy)), vs2);
+		vs2 = _mm_sub_pd(_mm_mul_pd(vb2, x), _mm_mul_pd(va2, vy));
+		_mm_storel_pd(out0 + i, vy);
+		_mm_storeh_pd(out1 + i, vy);
+	}
+
+	_mm_storeu_pd(s1 + g, vs1);
+	_mm_storeu_pd(s2 + g, vs2);
+#else
+	for(int l = g; l < g + BANK_WIDTH; l++){
+		processLane(l, input[l], output[l], nFrames);
+	}
+#endif
+}
+
+/**
+ * processLane filters a single lane with scalar code. Used for
+ * the lanes that do not fill a complete vector.
+ * @param l The lane to process
+ * @param input The input buffer of the lane
+ * @param output The output buffer of the lane
+ * @param nFrames The number of samples in the buffers
+ */
+void BiquadBank::processLane(int l, double *input, double *output, int nFrames){
+	double cb0 = b0[l], cb1 = b1[l], cb2 = b2[l];
+	double ca1 = a1[l], ca2 = a2[l];
+	double z1 = s1[l], z2 = s2[l];
+
+	for(int i = 0; i < nFrames; i++){
+		double x = input[i];
+		double y = cb0 * x + z1;
+		z1 = cb1 * x - ca1 * y + z2;
+		z2 = cb2 * x - ca2 * y;
+		output[i] = y;
+	}
+
+	s1[l] = z1;
+	s2[l] = z2;
+}
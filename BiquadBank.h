@@ -0,0 +1,141 @@
+#ifndef BIQUADBANK_H
+#define BIQUADBANK_H
+
+//include
+#include "Biquad.h"
+
+//number of filters processed per vector instruction
+#if defined(__AVX__)
+#define BANK_WIDTH 4
+#elif defined(__SSE2__) || defined(_M_X64)
+#define BANK_WIDTH 2
+#else
+#define BANK_WIDTH 1
+#endif
+
+/**
+ * BiquadBank runs several independent biquad filters (one per
+ * channel) side by side. The coefficients and the history of all
+ * the filters are stored in structure-of-arrays layout so that
+ * BANK_WIDTH channels are computed by each SSE/AVX instruction.
+ * The filters are designed with the same semantics as Biquad.
+ * @see Biquad
+ */
+class BiquadBank{
+protected:
+	int nLanes;					//number of filters in the bank
+	Biquad **designers;			//used to design the coFs of each lane
+
+	//normalized coFs (a0 = 1), one entry per lane
+	double *b0;
+	double *b1;
+	double *b2;
+	double *a1;
+	double *a2;
+
+	//transposed direct form II state, one entry per lane
+	double *s1;
+	double *s2;
+
+	/**
+	 * loadCoFs copies the normalized coefficients of a lane's
+	 * designer into the bank.
+	 * @param lane The lane to update
+	 */
+	void loadCoFs(int lane);
+
+	/**
+	 * processGroup filters BANK_WIDTH consecutive lanes with
+	 * vector instructions.
+	 * @param g The first lane of the group
+	 * @param input Array of nLanes input buffers
+	 * @param output Array of nLanes output buffers
+	 * @param nFrames The number of samples in each buffer
+	 */
+	void processGroup(int g, double **input, double **output, int nFrames);
+
+	/**
+	 * processLane filters a single lane with scalar code. Used for
+	 * the lanes that do not fill a complete vector.
+	 * @param l The lane to process
+	 * @param input The input buffer of the lane
+	 * @param output The output buffer of the lane
+	 * @param nFrames The number of samples in the buffers
+	 */
+	void processLane(int l, double *input, double *output, int nFrames);
+
+public:
+	/**
+	 * Creates a bank of n filters all using the same mode. Every
+	 * lane passes its input through unchanged until its
+	 * parameters are set.
+	 * @param n The number of filters in the bank
+	 * @param m The mode of the filters. See Biquad
+	 * @param bwm The bandwidth mode of the filters. See Biquad
+	 */
+	BiquadBank(int n, unsigned int m, unsigned int bwm);
+
+	~BiquadBank();
+
+	//not copyable, a copy would free the coefficient block and the designers twice
+	BiquadBank(const BiquadBank &) = delete;
+	BiquadBank &operator=(const BiquadBank &) = delete;
+
+	/**
+	 * setMode changes the mode of a single lane. The parameters of
+	 * the lane must be set again afterwards.
+	 * @param lane The lane to change
+	 * @param m The mode of the filter. See Biquad
+	 * @param bwm The bandwidth mode of the filter. See Biquad
+	 * @return true IFF lane is a valid lane
+	 */
+	bool setMode(int lane, unsigned int m, unsigned int bwm);
+
+	/**
+	 * Per lane equivalent of Biquad::setParamsQ()
+	 * @param lane The lane to update
+	 * @return true IFF lane is a valid lane
+	 * @see Biquad::setParamsQ()
+	 */
+	bool setParamsQ(int lane, double fs, double f, double q);
+
+	/**
+	 * Per lane equivalent of Biquad::setParamsBW()
+	 * @param lane The lane to update
+	 * @return true IFF the lane was updated
+	 * @see Biquad::setParamsBW()
+	 */
+	bool setParamsBW(int lane, double fs, double f, double b);
+
+	/**
+	 * Per lane equivalent of Biquad::setParamsSlope()
+	 * @param lane The lane to update
+	 * @return true IFF the lane was updated
+	 * @see Biquad::setParamsSlope()
+	 */
+	bool setParamsSlope(int lane, double fs, double f, double s, double dbg);
+
+	/**
+	 * initHist clears the history of every lane
+	 */
+	void initHist();
+
+	int getNumLanes(){return nLanes;}
+
+	/**
+	 * getFilter gives read access to the design parameters of a lane
+	 * @param lane The lane
+	 * @return The Biquad used to design the lane
+	 */
+	Biquad *getFilter(int lane){return designers[lane];}
+
+	/**
+	 * processBuffer applies every filter of the bank to its own
+	 * channel. Lane i reads input[i] and writes output[i].
+	 * @param input Array of nLanes input buffers of size nFrames
+	 * @param output Array of nLanes output buffers of size nFrames
+	 * @param nFrames The number of samples in each buffer
+	 */
+	void processBuffer(double **input, double **output, int nFrames);
+};
+#endif
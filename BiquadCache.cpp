@@ -0,0 +1,132 @@
+#include "BiquadCache.h"
+#include <cstddef>
+
+BiquadCacheEntry BiquadCache::entries[BIQUADCACHE_SIZE];
+unsigned char BiquadCache::hands[BIQUADCACHE_SETS];
+std::mutex BiquadCache::lock;
+std::atomic<bool> BiquadCache::enabled(false);
+std::atomic<unsigned long> BiquadCache::hits(0);
+std::atomic<unsigned long> BiquadCache::misses(0);
+
+bool BiquadDesignKey::operator==(const BiquadDesignKey &k) const{
+	return mode == k.mode && BWMode == k.BWMode && Fs == k.Fs && fc == k.fc
+		&& bw == k.bw && dBG == k.dBG && fastMath == k.fastMath;
+}
+
+//FNV-1a step over the bytes of a field
+static inline void hashBytes(unsigned int &h, const void *p, size_t n){
+	const unsigned char *b = (const unsigned char*)p;
+	for(size_t i = 0; i < n; i++){
+		h ^= b[i];
+		h *= 16777619u;
+	}
+}
+
+/**
+ * hashKey
+ * @param k The parameters of a design
+ * @return The first entry of the set of the design
+ */
+unsigned int BiquadCache::hashKey(const BiquadDesignKey &k){
+	unsigned int h = 2166136261u;
+	hashBytes(h, &k.mode, sizeof(k.mode));
+	hashBytes(h, &k.BWMode, sizeof(k.BWMode));
+	hashBytes(h, &k.Fs, sizeof(k.Fs));
+	hashBytes(h, &k.fc, sizeof(k.fc));
+	hashBytes(h, &k.bw, sizeof(k.bw));
+	hashBytes(h, &k.dBG, sizeof(k.dBG));
+	hashBytes(h, &k.fastMath, sizeof(k.fastMath));
+	return (h & (BIQUADCACHE_SETS - 1)) * BIQUADCACHE_WAYS;
+}
+
+/**
+ * lookup searches the cache for a design. Counts a hit or a
+ * miss. If another thread holds the cache the lookup is a miss.
+ * @param k The parameters of the design
+ * @param d Pass by call design, only written on a hit
+ * @return true IFF the design was found
+ */
+bool BiquadCache::lookup(const BiquadDesignKey &k, BiquadDesign &d){
+	std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+	if(guard.owns_lock()){
+		unsigned int first = hashKey(k);
+		for(unsigned int w = 0; w < BIQUADCACHE_WAYS; w++){
+			BiquadCacheEntry &e = entries[first + w];
+			if(e.used && e.key == k){
+				e.referenced = true;
+				d = e.design;
+				hits++;
+				return true;
+			}
+		}
+	}
+	misses++;
+	return false;
+}
+
+/**
+ * store adds a design to the cache, replacing an older one if
+ * its set is full. The clock hand of the set sweeps its entries
+ * from where it last stopped, clearing the referenced bits,
+ * until it finds one that was not used since the hand last
+ * passed it. The hand then stops past the replaced entry, so
+ * the new design is the last one the hand reaches. If another
+ * thread holds the cache the design is not stored.
+ * @param k The parameters of the design
+ * @param d The design
+ */
+void BiquadCache::store(const BiquadDesignKey &k, const BiquadDesign &d){
+	std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+	if(!guard.owns_lock()) return;
+
+	unsigned int first = hashKey(k);
+	BiquadCacheEntry *victim = 0;
+	for(unsigned int w = 0; w < BIQUADCACHE_WAYS && !victim; w++){
+		BiquadCacheEntry &e = entries[first + w];
+		if(!e.used || e.key == k) victim = &e;
+	}
+	//one turn at most clears every referenced bit
+	unsigned char &hand = hands[first / BIQUADCACHE_WAYS];
+	while(!victim){
+		BiquadCacheEntry &e = entries[first + hand];
+		if(e.referenced) e.referenced = false;
+		else victim = &e;
+		hand = (hand + 1) & (BIQUADCACHE_WAYS - 1);
+	}
+
+	victim->used = true;
+	victim->referenced = false;
+	victim->key = k;
+	victim->design = d;
+}
+
+/**
+ * clear removes every design and resets the counters
+ */
+void BiquadCache::clear(){
+	std::lock_guard<std::mutex> guard(lock);
+	for(int i = 0; i < BIQUADCACHE_SIZE; i++){
+		entries[i].used = false;
+		entries[i].referenced = false;
+	}
+	for(int s = 0; s < BIQUADCACHE_SETS; s++) hands[s] = 0;
+	hits = 0;
+	misses = 0;
+}
+
+unsigned long BiquadCache::getHits(){
+	return hits;
+}
+
+unsigned long BiquadCache::getMisses(){
+	return misses;
+}
+
+unsigned long BiquadCache::getSize(){
+	std::lock_guard<std::mutex> guard(lock);
+	unsigned long n = 0;
+	for(int i = 0; i < BIQUADCACHE_SIZE; i++){
+		if(entries[i].used) n++;
+	}
+	return n;
+}
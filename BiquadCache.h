@@ -0,0 +1,120 @@
+#ifndef BIQUADCACHE_H
+#define BIQUADCACHE_H
+
+//include
+#include <mutex>
+#include <atomic>
+
+//number of designs the cache holds, a power of 2
+#define BIQUADCACHE_SIZE 4096
+//number of entries of a set, a power of 2
+#define BIQUADCACHE_WAYS 8
+#define BIQUADCACHE_SETS (BIQUADCACHE_SIZE / BIQUADCACHE_WAYS)
+
+/**
+ * Parameters that fully determine the design of a Biquad
+ * @see Biquad
+ */
+struct BiquadDesignKey{
+	unsigned int mode;
+	unsigned int BWMode;
+	double Fs;
+	double fc;
+	double bw;					//Q, BW or slope depending on BWMode
+	double dBG;					//0 for non-shelving filters
+	bool fastMath;				//true IFF designed with FastMath
+
+	bool operator==(const BiquadDesignKey &k) const;
+};
+
+/**
+ * Result of a Biquad design: the intermediate parameters and
+ * the coefficients before normalization.
+ * @see Biquad
+ */
+struct BiquadDesign{
+	double omega0, cosW0, sinW0;
+	double alpha, alphaPrime, gain;
+	double b0, b1, b2;
+	double a0, a1, a2;
+};
+
+/**
+ * An entry of BiquadCache
+ */
+struct BiquadCacheEntry{
+	bool used;
+	bool referenced;			//second chance bit of the clock eviction
+	BiquadDesignKey key;
+	BiquadDesign design;
+};
+
+/**
+ * BiquadCache is a process-wide, thread-safe cache of Biquad
+ * designs. When it is enabled, Biquad::setParamsQ, setParamsBW
+ * and setParamsSlope look their design up here before calling
+ * into libm, so recalling presets or building many identical
+ * filters only designs each distinct filter once.
+ * The cache is a static table of BIQUADCACHE_SIZE entries in
+ * sets of BIQUADCACHE_WAYS: a design can only be stored in the
+ * set of its hash, and when the set is full one of its entries
+ * is replaced by clock (second chance) eviction, with one hand
+ * per set. The cache never
+ * allocates memory, and it never waits for its lock: a lookup
+ * made while another thread holds it is a miss, and a store is
+ * dropped. Setters called from the audio thread, e.g. under
+ * automation, are therefore bounded in time and memory.
+ * @see Biquad
+ */
+class BiquadCache{
+protected:
+	static BiquadCacheEntry entries[BIQUADCACHE_SIZE];
+	static unsigned char hands[BIQUADCACHE_SETS];	//clock hand of each set
+	static std::mutex lock;
+	static std::atomic<bool> enabled;
+	static std::atomic<unsigned long> hits;
+	static std::atomic<unsigned long> misses;
+
+	/**
+	 * hashKey
+	 * @param k The parameters of a design
+	 * @return The first entry of the set of the design
+	 */
+	static unsigned int hashKey(const BiquadDesignKey &k);
+
+public:
+	/**
+	 * setEnabled turns the cache on or off for every Biquad in
+	 * the process. The cache is off by default.
+	 * @param e IFF true the Biquad setters use the cache
+	 */
+	static void setEnabled(bool e){enabled = e;}
+	static bool isEnabled(){return enabled;}
+
+	/**
+	 * lookup searches the cache for a design. Counts a hit or a
+	 * miss.
+	 * @param k The parameters of the design
+	 * @param d Pass by call design, only written on a hit
+	 * @return true IFF the design was found
+	 */
+	static bool lookup(const BiquadDesignKey &k, BiquadDesign &d);
+
+	/**
+	 * store adds a design to the cache, replacing an older one if
+	 * its entries are full
+	 * @param k The parameters of the design
+	 * @param d The design
+	 */
+	static void store(const BiquadDesignKey &k, const BiquadDesign &d);
+
+	/**
+	 * clear removes every design and resets the counters
+	 */
+	static void clear();
+
+	static unsigned long getHits();
+	static unsigned long getMisses();
+	static unsigned long getSize();
+};
+#endif
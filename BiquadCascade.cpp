@@ -0,0 +1,131 @@
+#include "BiquadCascade.h"
+
+/**
+ * Creates an empty cascade
+ * @param n The maximum number of sections
+ */
+BiquadCascade::BiquadCascade(int n){
+	maxSections = n;
+	nSections = 0;
+	nActive = 0;
+	sections = new Biquad*[maxSections];
+	bypassed = new bool[maxSections];
+	active = new int[maxSections];
+}
+
+BiquadCascade::~BiquadCascade(){
+	for(int i = 0; i < nSections; i++) delete sections[i];
+	delete[] sections;
+	delete[] bypassed;
+	delete[] active;
+}
+
+/**
+ * updateActive rebuilds the list of the sections that are
+ * not bypassed.
+ */
+void BiquadCascade::updateActive(){
+	nActive = 0;
+	for(int i = 0; i < nSections; i++){
+		if(!bypassed[i]) active[nActive++] = i;
+	}
+}
+
+/**
+ * addSection appends a new section at the end of the cascade.
+ * The parameters have the same meaning as in the general
+ * Biquad constructor.
+ * @see Biquad
+ * @return The index of the new section, or -1 if the cascade is full
+ */
+int BiquadCascade::addSection(unsigned int m, unsigned int bwm, double fs, double f, double q, double dbg){
+	if(nSections >= maxSections) return -1;
+	sections[nSections] = new Biquad(m, bwm, fs, f, q, dbg);
+	bypassed[nSections] = false;
+	nSections++;
+	updateActive();
+	return nSections - 1;
+}
+
+/**
+ * getSection gives access to a section so that its parameters
+ * can be changed with the Biquad setters.
+ * @param i The index of the section
+ * @return The section, or 0 if i is not a valid index
+ */
+Biquad *BiquadCascade::getSection(int i){
+	if(i < 0 || i >= nSections) return 0;
+	return sections[i];
+}
+
+/**
+ * setBypass enables or bypasses a section. The history of a
+ * section is cleared when it is enabled again.
+ * @param i The index of the section
+ * @param b IFF true the section is bypassed
+ * @return true IFF i is a valid index
+ */
+bool BiquadCascade::setBypass(int i, bool b){
+	if(i < 0 || i >= nSections) return false;
+	if(bypassed[i] && !b) sections[i]->initHist();
+	bypassed[i] = b;
+	updateActive();
+	return true;
+}
+
+/**
+ * initHist clears the history of every section
+ */
+void BiquadCascade::initHist(){
+	for(int i = 0; i < nSections; i++) sections[i]->initHist();
+}
+
+/**
+ * processSamples is the processing core shared by the double
+ * and float versions of processBuffer.
+ * @see processBuffer()
+ */
+template<typename T>
+void BiquadCascade::processSamples(T *input, T *output, int nFrames){
+	//set once here so that the sections do not change the mode
+	ScopedNoDenormals noDenormals;
+	if(nActive == 0){
+		if(output != input){
+			for(int i = 0; i < nFrames; i++) output[i] = input[i];
+		}
+		return;
+	}
+
+	for(int start = 0; start < nFrames; start += CASCADE_BLOCK){
+		int n = nFrames - start;
+		if(n > CASCADE_BLOCK) n = CASCADE_BLOCK;
+
+		//the first section reads the input, the others work in place
+		sections[active[0]]->processBufferTDF2(input + start, output + start, n);
+		for(int s = 1; s < nActive; s++){
+			sections[active[s]]->processBufferTDF2(output + start, output + start, n);
+		}
+	}
+}
+
+/**
+ * processBuffer applies every active section to a buffer
+ * @param input A double array of size nFrames holding the intput signal
+ * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+ * @param nFrames The number of samples in the input and output buffer.
+ */
+void BiquadCascade::processBuffer(double *input, double *output, int nFrames){
+	processSamples(input, output, nFrames);
+}
+
+/**
+ * processBuffer applies every active section to a float32
+ * buffer using float arithmetic.
+ * @param input A float array of size nFrames holding the intput signal
+ * @param output A float buffer of size nFrames for a pass by call output. May be the same as input.
+ * @param nFrames The number of samples in the input and output buffer.
+ * @see Biquad::processBufferTDF2()
+ */
+void BiquadCascade::processBuffer(float *input, float *output, int nFrames){
+	processSamples(input, output, nFrames);
+}
@@ -0,0 +1,110 @@
+#ifndef BIQUADCASCADE_H
+#define BIQUADCASCADE_H
+
+//include
+#include "Biquad.h"
+
+//number of samples pushed through every section at a time
+#define CASCADE_BLOCK 64
+
+/**
+ * BiquadCascade owns a series of Biquad sections (for example the
+ * bands of a parametric EQ) and applies them all in a single pass
+ * over the buffer. The buffer is walked in sub-blocks of
+ * CASCADE_BLOCK samples that stay in cache while every active
+ * section filters them in place, so no intermediate buffers are
+ * needed. Bypassed sections are removed from the processing list
+ * and cost nothing.
+ * @see Biquad
+ */
+class BiquadCascade{
+protected:
+	int maxSections;			//capacity of the cascade
+	int nSections;				//number of sections added
+	Biquad **sections;			//the sections, in processing order
+	bool *bypassed;				//bypass flag of each section
+
+	int nActive;				//number of sections not bypassed
+	int *active;				//indices of the sections not bypassed
+
+	/**
+	 * updateActive rebuilds the list of the sections that are
+	 * not bypassed.
+	 */
+	void updateActive();
+
+	/**
+	 * processSamples is the processing core shared by the double
+	 * and float versions of processBuffer.
+	 * @see processBuffer()
+	 */
+	template<typename T>
+	void processSamples(T *input, T *output, int nFrames);
+
+public:
+	/**
+	 * Creates an empty cascade
+	 * @param n The maximum number of sections
+	 */
+	BiquadCascade(int n);
+
+	~BiquadCascade();
+
+	//not copyable, a copy would free the sections twice
+	BiquadCascade(const BiquadCascade &) = delete;
+	BiquadCascade &operator=(const BiquadCascade &) = delete;
+
+	/**
+	 * addSection appends a new section at the end of the cascade.
+	 * The parameters have the same meaning as in the general
+	 * Biquad constructor.
+	 * @see Biquad
+	 * @return The index of the new section, or -1 if the cascade is full
+	 */
+	int addSection(unsigned int m, unsigned int bwm, double fs, double f, double q, double dbg);
+
+	/**
+	 * getSection gives access to a section so that its parameters
+	 * can be changed with the Biquad setters.
+	 * @param i The index of the section
+	 * @return The section, or 0 if i is not a valid index
+	 */
+	Biquad *getSection(int i);
+
+	/**
+	 * setBypass enables or bypasses a section. The history of a
+	 * section is cleared when it is enabled again.
+	 * @param i The index of the section
+	 * @param b IFF true the section is bypassed
+	 * @return true IFF i is a valid index
+	 */
+	bool setBypass(int i, bool b);
+
+	bool isBypassed(int i){return bypassed[i];}
+	int getNumSections(){return nSections;}
+	int getNumActive(){return nActive;}
+
+	/**
+	 * initHist clears the history of every section
+	 */
+	void initHist();
+
+	/**
+	 * processBuffer applies every active section to a buffer
+	 * @param input A double array of size nFrames holding the intput signal
+	 * @param output A double buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the input and output buffer.
+	 */
+	void processBuffer(double *input, double *output, int nFrames);
+
+	/**
+	 * processBuffer applies every active section to a float32
+	 * buffer using float arithmetic.
+	 * @param input A float array of size nFrames holding the intput signal
+	 * @param output A float buffer of size nFrames for a pass by call output. May be the same as input.
+	 * @param nFrames The number of samples in the input and output buffer.
+	 * @see Biquad::processBufferTDF2()
+	 */
+	void processBuffer(float *input, float *output, int nFrames);
+};
+#endif
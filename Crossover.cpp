@@ -0,0 +1,174 @@
+#include "Crossover.h"
+
+/**
+ * Creates a crossover with nFreqs+1 bands.
+ * @param fs The sample rate
+ * @param f The nFreqs split frequencies in Hz. They are sorted.
+ * @param nFreqs The number of split frequencies, at least 1
+ */
+Crossover::Crossover(double fs, double *f, int nFreqs){
+	if(nFreqs < 0) nFreqs = 0;
+	nBands = nFreqs + 1;
+	Fs = fs;
+	maxFrames = 0;
+	bandData = 0;
+	bandBuffers = 0;
+
+	//copy and sort the frequencies
+	freqs = new double[nBands];
+	for(int i = 0; i < nFreqs; i++){
+		double v = f[i];
+		int j = i;
+		for(; j > 0 && freqs[j-1] > v; j--) freqs[j] = freqs[j-1];
+		freqs[j] = v;
+	}
+
+	splits = new LinkwitzRiley*[nBands];
+	allpass = new BiquadCascade*[nBands];
+	for(int k = 0; k < nBands; k++){
+		splits[k] = 0;
+		allpass[k] = 0;
+	}
+	for(int k = 0; k < nFreqs; k++) splits[k] = new LinkwitzRiley(Fs, freqs[k]);
+
+	//band k is aligned with the splits k+1 .. nFreqs-1
+	for(int k = 0; k + 1 < nFreqs; k++){
+		allpass[k] = new BiquadCascade(nFreqs - 1 - k);
+		for(int s = k + 1; s < nFreqs; s++){
+			allpass[k]->addSection(4, 0, Fs, freqs[s], 1 / SQRT2, 0);
+		}
+	}
+}
+
+Crossover::~Crossover(){
+	for(int k = 0; k < nBands; k++){
+		delete splits[k];
+		delete allpass[k];
+	}
+	delete[] splits;
+	delete[] allpass;
+	delete[] freqs;
+	delete[] bandBuffers;
+	delete[] bandData;
+}
+
+/**
+ * setFreq changes one split frequency. The order of the
+ * frequencies must be kept.
+ * @param k The index of the split
+ * @param f The new frequency in Hz
+ * @return true IFF k is valid and f lies between its neighbours
+ */
+bool Crossover::setFreq(int k, double f){
+	if(k < 0 || k >= nBands - 1) return false;
+	if(f <= 0 || f >= Fs / 2) return false;
+	if(k > 0 && f < freqs[k-1]) return false;
+	if(k < nBands - 2 && f > freqs[k+1]) return false;
+
+	freqs[k] = f;
+	splits[k]->setFc(f);
+	//split k is compensated in the bands below it
+	for(int b = 0; b < k; b++){
+		allpass[b]->getSection(k - b - 1)->setParamsQ(-1, f, -1);
+	}
+	return true;
+}
+
+/**
+ * setFs changes the sample rate of every filter
+ * @param fs The new sample rate
+ * @return true IFF fs is valid
+ */
+bool Crossover::setFs(double fs){
+	if(fs <= 0) return false;
+	Fs = fs;
+	for(int k = 0; k < nBands - 1; k++) splits[k]->setFs(fs);
+	for(int b = 0; b < nBands; b++){
+		if(!allpass[b]) continue;
+		for(int s = 0; s < allpass[b]->getNumSections(); s++){
+			allpass[b]->getSection(s)->setParamsQ(fs, -1, -1);
+		}
+	}
+	return true;
+}
+
+/**
+ * prepare allocates the internal band buffers used by
+ * processBuffer(double*, int). Not real time safe.
+ * @param n The largest number of samples per buffer
+ */
+void Crossover::prepare(int n){
+	if(n <= maxFrames && bandBuffers) return;
+	delete[] bandBuffers;
+	delete[] bandData;
+	maxFrames = n;
+	bandData = new double[nBands * maxFrames];
+	bandBuffers = new double*[nBands];
+	for(int b = 0; b < nBands; b++) bandBuffers[b] = bandData + b * maxFrames;
+}
+
+/**
+ * initHist clears the history of every filter
+ */
+void Crossover::initHist(){
+	for(int k = 0; k < nBands - 1; k++) splits[k]->initHist();
+	for(int b = 0; b < nBands; b++){
+		if(allpass[b]) allpass[b]->initHist();
+	}
+}
+
+/**
+ * processSamples is the processing core shared by the double
+ * and float versions of processBuffer. Split k reads band k,
+ * which holds the high output of split k-1, and writes its low
+ * output back to band k and its high output to band k+1.
+ * @see processBuffer()
+ */
+template<typename T>
+void Crossover::processSamples(T *input, T **bands, int nFrames){
+	if(nBands == 1){
+		if(bands[0] != input){
+			for(int i = 0; i < nFrames; i++) bands[0][i] = input[i];
+		}
+		return;
+	}
+
+	splits[0]->processBuffer(input, bands[0], bands[1], nFrames);
+	for(int k = 1; k < nBands - 1; k++){
+		splits[k]->processBuffer(bands[k], bands[k], bands[k+1], nFrames);
+	}
+	for(int b = 0; b < nBands - 2; b++){
+		allpass[b]->processBuffer(bands[b], bands[b], nFrames);
+	}
+}
+
+/**
+ * processBuffer splits the input into the internal band
+ * buffers, see getBand.
+ * @param input The input buffer
+ * @param nFrames The number of samples, at most the size given to prepare
+ * @return false IFF nFrames does not fit in the band buffers
+ */
+bool Crossover::processBuffer(double *input, int nFrames){
+	if(!bandBuffers || nFrames > maxFrames) return false;
+	processSamples(input, bandBuffers, nFrames);
+	return true;
+}
+
+/**
+ * processBuffer splits the input into nBands caller owned
+ * buffers. input may be bands[0].
+ * @param input The input buffer
+ * @param bands nBands buffers of size nFrames, from low to high
+ * @param nFrames The number of samples in the buffers
+ */
+void Crossover::processBuffer(double *input, double **bands, int nFrames){
+	processSamples(input, bands, nFrames);
+}
+
+/**
+ * Float version of processBuffer(double*, double**, int)
+ */
+void Crossover::processBuffer(float *input, float **bands, int nFrames){
+	processSamples(input, bands, nFrames);
+}
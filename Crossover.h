@@ -0,0 +1,119 @@
+#ifndef CROSSOVER_H
+#define CROSSOVER_H
+
+//include
+#include "LinkwitzRiley.h"
+#include "BiquadCascade.h"
+
+/**
+ * Crossover splits a signal into N bands with N-1 Linkwitz-Riley
+ * crossovers laid out as a chain: split k separates band k from
+ * everything above it and passes its high output on to split
+ * k+1. Band k is then delayed in phase by the allpass of every
+ * split above it (a second order allpass with Q = 1/sqrt(2) at
+ * the split frequency, which is the sum LP + HP of a 4th order
+ * LR), so that all the bands have the same phase and sum flat.
+ * The bands are written in place along the chain, so no
+ * intermediate buffer is needed.
+ * @see LinkwitzRiley
+ */
+class Crossover{
+protected:
+	int nBands;					//number of bands
+	double Fs;					//sample rate
+	double *freqs;				//the nBands-1 split frequencies, ascending
+	LinkwitzRiley **splits;		//split k is at freqs[k]
+	BiquadCascade **allpass;	//phase compensation of band k, 0 if none
+
+	//preallocated band buffers, see prepare()
+	int maxFrames;
+	double *bandData;
+	double **bandBuffers;
+
+	/**
+	 * processSamples is the processing core shared by the double
+	 * and float versions of processBuffer.
+	 * @see processBuffer()
+	 */
+	template<typename T>
+	void processSamples(T *input, T **bands, int nFrames);
+
+public:
+	/**
+	 * Creates a crossover with nFreqs+1 bands.
+	 * @param fs The sample rate
+	 * @param f The nFreqs split frequencies in Hz. They are sorted.
+	 * @param nFreqs The number of split frequencies, at least 1
+	 */
+	Crossover(double fs, double *f, int nFreqs);
+
+	~Crossover();
+
+	//not copyable, a copy would free the filters of the bands twice
+	Crossover(const Crossover &) = delete;
+	Crossover &operator=(const Crossover &) = delete;
+
+	/**
+	 * setFreq changes one split frequency. The order of the
+	 * frequencies must be kept.
+	 * @param k The index of the split
+	 * @param f The new frequency in Hz
+	 * @return true IFF k is valid and f lies between its neighbours
+	 */
+	bool setFreq(int k, double f);
+
+	/**
+	 * setFs changes the sample rate of every filter
+	 * @param fs The new sample rate
+	 * @return true IFF fs is valid
+	 */
+	bool setFs(double fs);
+
+	int getNumBands(){return nBands;}
+	double getFreq(int k){return freqs[k];}
+	double getFs(){return Fs;}
+
+	/**
+	 * prepare allocates the internal band buffers used by
+	 * processBuffer(double*, int). Not real time safe.
+	 * @param n The largest number of samples per buffer
+	 */
+	void prepare(int n);
+
+	/**
+	 * getBand gives the output of a band after
+	 * processBuffer(double*, int)
+	 * @param b The band, 0 being the lowest
+	 * @return The band buffer, 0 if prepare was not called
+	 */
+	double *getBand(int b){return bandBuffers ? bandBuffers[b] : 0;}
+
+	/**
+	 * initHist clears the history of every filter
+	 */
+	void initHist();
+
+	/**
+	 * processBuffer splits the input into the internal band
+	 * buffers, see getBand.
+	 * @param input The input buffer
+	 * @param nFrames The number of samples, at most the size given to prepare
+	 * @return false IFF nFrames does not fit in the band buffers
+	 */
+	bool processBuffer(double *input, int nFrames);
+
+	/**
+	 * processBuffer splits the input into nBands caller owned
+	 * buffers. input may be bands[0].
+	 * @param input The input buffer
+	 * @param bands nBands buffers of size nFrames, from low to high
+	 * @param nFrames The number of samples in the buffers
+	 */
+	void processBuffer(double *input, double **bands, int nFrames);
+
+	/**
+	 * Float version of processBuffer(double*, double**, int)
+	 */
+	void processBuffer(float *input, float **bands, int nFrames);
+};
+#endif
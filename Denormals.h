@@ -0,0 +1,126 @@
+#ifndef DENORMALS_H
+#define DENORMALS_H
+
+//include
+#include <atomic>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DENORMALS_SSE
+#elif defined(__aarch64__)
+#define DENORMALS_ARM64
+#endif
+
+//state magnitude below which the software fallback flushes to 0
+#define DENORMAL_FLOOR 1e-18
+
+/**
+ * Denormals controls the library-wide denormal protection. When a
+ * silent signal decays through the feedback of a recursive filter
+ * the state becomes subnormal, which is 10-100x slower on x86.
+ * When the protection is enabled every processBuffer of the
+ * recursive processors sets flush-to-zero and denormals-are-zero
+ * for its own duration with ScopedNoDenormals. On platforms where
+ * this is not available the processors instead flush their state
+ * to 0 at the end of every buffer once it falls below
+ * DENORMAL_FLOOR.
+ * @see ScopedNoDenormals
+ */
+class Denormals{
+protected:
+	static std::atomic<bool> &flag(){
+		static std::atomic<bool> enabled(false);
+		return enabled;
+	}
+
+public:
+	/**
+	 * setEnabled turns the protection on or off for the whole
+	 * library. It is off by default.
+	 * @param e IFF true the processors avoid denormals
+	 */
+	static void setEnabled(bool e){flag() = e;}
+	static bool isEnabled(){return flag();}
+
+	/**
+	 * hasHardwareFlush tells if this platform supports setting
+	 * flush-to-zero in the floating point unit.
+	 * @return true IFF ScopedNoDenormals can set FTZ/DAZ
+	 */
+	static bool hasHardwareFlush(){
+#if defined(DENORMALS_SSE) || defined(DENORMALS_ARM64)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * flush sets a state variable to 0 if it is below DENORMAL_FLOOR
+	 * @param v The state variable
+	 */
+	template<typename T>
+	static void flush(T &v){
+		if(std::fabs(v) < (T)DENORMAL_FLOOR) v = 0;
+	}
+};
+
+/**
+ * ScopedNoDenormals sets flush-to-zero and denormals-are-zero
+ * while it is in scope, if the protection of Denormals is enabled
+ * and the platform supports it, and restores the previous mode
+ * when it goes out of scope. The mode is per thread.
+ * @see Denormals
+ */
+class ScopedNoDenormals{
+protected:
+	bool active;				//true IFF the hardware flush is in effect
+	bool changed;				//true IFF the mode has to be restored
+	unsigned long long saved;	//previous control register
+
+public:
+	ScopedNoDenormals(){
+		active = false;
+		changed = false;
+		saved = 0;
+		if(!Denormals::isEnabled()) return;
+#if defined(DENORMALS_SSE)
+		//FTZ is bit 15 and DAZ is bit 6 of MXCSR
+		saved = _mm_getcsr();
+		if((saved & 0x8040) != 0x8040){
+			_mm_setcsr((unsigned int)saved | 0x8040);
+			changed = true;
+		}
+		active = true;
+#elif defined(DENORMALS_ARM64)
+		//FZ is bit 24 of FPCR
+		unsigned long long fpcr;
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+		saved = fpcr;
+		if(!(fpcr & (1ULL << 24))){
+			fpcr |= 1ULL << 24;
+			__asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+			changed = true;
+		}
+		active = true;
+#endif
+	}
+
+	~ScopedNoDenormals(){
+		if(!changed) return;
+#if defined(DENORMALS_SSE)
+		_mm_setcsr((unsigned int)saved);
+#elif defined(DENORMALS_ARM64)
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(saved));
+#endif
+	}
+
+	/**
+	 * needsFlush tells a processor if it should flush its state
+	 * in software at the end of the buffer.
+	 * @return true IFF the protection is enabled but not done in hardware
+	 */
+	bool needsFlush(){return !active && Denormals::isEnabled();}
+};
+#endif
@@ -11,6 +11,7 @@ Dynamics::Dynamics(){
 	atkSample = -1;
 	relSample = -1;
 	effRatio = 1;
+	fastMath = false;
 }
 
 /**
@@ -30,6 +31,7 @@ Dynamics::Dynamics(unsigned int m){
 	atkSample = -1;
 	relSample = -1;
 	effRatio = 1;
+	fastMath = false;
 }
 
 /**
@@ -50,6 +52,7 @@ Dynamics::Dynamics(unsigned int m, double fs){
 	atkSample = -1;
 	relSample = -1;
 	effRatio = 1;
+	fastMath = false;
 }
 
 /**
@@ -125,7 +128,8 @@ void Dynamics::setParamsdB(double t, double rat, double a, double r, double k, d
  * @see Averages
  * @return The average level of the input buffer
  */
-double Dynamics::getBufferLevel(double *input, int nFrames){
+template<typename T>
+double Dynamics::getBufferLevel(T *input, int nFrames){
 	switch(mode){
 	case 1:
 		return absAvg(input,nFrames);
@@ -141,14 +145,16 @@ double Dynamics::getBufferLevel(double *input, int nFrames){
 }
 
 /**
- * processBuffer applies the compression to an input
+ * processSamples is the processing core shared by every
+ * version of processBuffer. The gain computer runs in double
+ * and only the buffers use the sample type T.
  * @param input The input sample buffer
+ * @param l The level the gain is computed from
  * @param output Pass by call output buffer
  * @param nFrames The number of samples in the input and output buffer
  */
-void Dynamics::processBuffer(double *input, double *output, int nFrames){
-	double l = getBufferLevel(input, nFrames);
-
+template<typename T>
+void Dynamics::processSamples(T *input, double l, T *output, int nFrames){
 	//process audio
 	for(int i = 0; i < nFrames; i++){	
 		double effGain = 1;
@@ -197,10 +203,20 @@ void Dynamics::processBuffer(double *input, double *output, int nFrames){
 
 			effGain = 1 + (kMod * effRatio);
 		}
-		output[i] = gain* effGain * input[i];
+		output[i] = (T)(gain* effGain * input[i]);
 	}
 }
 
+/**
+ * processBuffer applies the compression to an input
+ * @param input The input sample buffer
+ * @param output Pass by call output buffer
+ * @param nFrames The number of samples in the input and output buffer
+ */
+void Dynamics::processBuffer(double *input, double *output, int nFrames){
+	processSamples(input, getBufferLevel(input, nFrames), output, nFrames);
+}
+
 /**
  * processBuffer applies the compression to an input
  * @param input The input sample buffer
@@ -209,56 +225,99 @@ void Dynamics::processBuffer(double *input, double *output, int nFrames){
  * @param nFrames The number of samples in the input and output buffer
  */
 void Dynamics::processBuffer(double *input, double *sideChain, double *output, int nFrames){
-	double l = getBufferLevel(sideChain, nFrames);
+	processSamples(input, getBufferLevel(sideChain, nFrames), output, nFrames);
+}
 
-	//process audio
-	for(int i = 0; i < nFrames; i++){	
-		double effGain = 1;
-	
-		//set effective gain
-		if(ratio < 1){//compressor, limited, inverter
-			//check if we are engaged
-			if(l > thresh){
-				//check if we are in the attack
-				if(effRatio > ratio) effRatio -= effRatio / atk;
+/**
+ * processBuffer applies the compression to a float32 input
+ * @param input The input sample buffer
+ * @param output Pass by call output buffer
+ * @param nFrames The number of samples in the input and output buffer
+ */
+void Dynamics::processBuffer(float *input, float *output, int nFrames){
+	processSamples(input, getBufferLevel(input, nFrames), output, nFrames);
+}
 
-				//check if we overshot
-				if(effRatio < ratio) effRatio = ratio;
-			}
-			else{//we are disengaged
-				//check if we are in the release
-				if(effRatio < 1) effRatio += effRatio / rel;
+/**
+ * processBuffer applies the compression to a float32 input
+ * @param input The input sample buffer
+ * @param sideChain The input buffer for a sidechain
+ * @param output Pass by call output buffer
+ * @param nFrames The number of samples in the input and output buffer
+ */
+void Dynamics::processBuffer(float *input, float *sideChain, float *output, int nFrames){
+	processSamples(input, getBufferLevel(sideChain, nFrames), output, nFrames);
+}
 
-				if(effRatio > 1) effRatio = 1;
-			}
-			//knee
-			if(l - thresh > knee) kMod = 1;
-			else kMod = knee / (l - thresh);
-			effGain = 1 - (knee * effRatio);
-		}
-		else{//Expander
-			//we are engaged
-			if(l > thresh){
-				//check if we are in atk
-				if(effRatio < ratio) effRatio += effRatio / atk;
+/**
+ * applyEvent stores the value of one event. Attack and release
+ * times below 1 sample are ignored, they divide the ratio steps.
+ * @param ev The event
+ * @return true IFF the event changed a parameter
+ */
+bool Dynamics::applyEvent(const ParameterEvent &ev){
+	switch(ev.param){
+	case THRESH_PARAM:
+		thresh = ev.value;
+		return true;
+	case RATIO_PARAM:
+		ratio = ev.value;
+		return true;
+	case ATK_PARAM:
+		if(!(ev.value >= 1)) return false;
+		atk = (int)ev.value;
+		return true;
+	case REL_PARAM:
+		if(!(ev.value >= 1)) return false;
+		rel = (int)ev.value;
+		return true;
+	case KNEE_PARAM:
+		knee = ev.value;
+		return true;
+	case GAIN_PARAM:
+		gain = ev.value;
+		return true;
+	default:
+		return false;
+	}
+}
 
-				//check if we went above ratio
-				if(effRatio > ratio) effRatio = ratio;
-			}
-			else{	//we are disengaged
-				//check if we are in the release
-				if(effRatio > 1) effRatio -= effRatio / rel;
+/**
+ * processEvents is the core of the event list processBuffer. The
+ * parameters are read by processSamples, so nothing has to be
+ * updated after an event.
+ * @see splitAtEvents()
+ * @param input The input sample buffer
+ * @param l The level the gain is computed from
+ * @param output Pass by call output buffer
+ * @param nFrames The number of samples in the input and output buffer
+ * @param events The events, sorted by offset
+ * @param nEvents The number of events
+ */
+template<typename T>
+void Dynamics::processEvents(T *input, double l, T *output, int nFrames, const ParameterEvent *events, int nEvents){
+	splitAtEvents(events, nEvents, nFrames,
+		[this](const ParameterEvent &ev){return applyEvent(ev);},
+		[](){},
+		[this, input, l, output](int pos, int n){processSamples(input + pos, l, output + pos, n);});
+}
 
-				//check if we overshot unity
-				if(effRatio < 1) effRatio = 1;
-			}
+void Dynamics::processBuffer(double *input, double *output, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, getBufferLevel(input, nFrames), output, nFrames, events, nEvents);
+}
 
-			//knee
-			if(l - thresh > knee) kMod = 1;
-			else kMod = (l - thresh) / knee;
+void Dynamics::processBuffer(double *input, double *sideChain, double *output, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, getBufferLevel(sideChain, nFrames), output, nFrames, events, nEvents);
+}
 
-			effGain = 1 + (kMod * effRatio);
-		}
-		output[i] = gain* effGain * input[i];
-	}
-}
\ No newline at end of file
+void Dynamics::processBuffer(float *input, float *output, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, getBufferLevel(input, nFrames), output, nFrames, events, nEvents);
+}
+
+void Dynamics::processBuffer(float *input, float *sideChain, float *output, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, getBufferLevel(sideChain, nFrames), output, nFrames, events, nEvents);
+}
+
+//instantiate the level detector for the supported sample types
+template double Dynamics::getBufferLevel<double>(double *input, int nFrames);
+template double Dynamics::getBufferLevel<float>(float *input, int nFrames);
\ No newline at end of file
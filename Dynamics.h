@@ -4,6 +4,8 @@
 //include
 #include <cmath>
 #include "Averages.cpp"
+#include "FastMath.h"
+#include "ParameterEvent.h"
 
 /**
  * Dynamics is a class that is used to alter the dynamic range
@@ -57,6 +59,43 @@ protected:
 	 * 4:	Absolute Midpoint
 	 */
 	unsigned int mode; 
+
+	//true IFF the dB conversions use FastMath
+	bool fastMath;
+
+	/**
+	 * processSamples is the processing core shared by every
+	 * version of processBuffer. The gain computer runs in double
+	 * and only the buffers use the sample type T.
+	 * @param input The input sample buffer
+	 * @param l The level the gain is computed from
+	 * @param output Pass by call output buffer
+	 * @param nFrames The number of samples in the input and output buffer
+	 */
+	template<typename T>
+	void processSamples(T *input, double l, T *output, int nFrames);
+
+	/**
+	 * applyEvent stores the value of one event.
+	 * @param ev The event
+	 * @return true IFF the event changed a parameter, false for an
+	 * attack or release below 1 sample
+	 */
+	bool applyEvent(const ParameterEvent &ev);
+
+	/**
+	 * processEvents is the core of the event list processBuffer.
+	 * The level is computed once for the whole buffer, as in the
+	 * other versions of processBuffer.
+	 * @param input The input sample buffer
+	 * @param l The level the gain is computed from
+	 * @param output Pass by call output buffer
+	 * @param nFrames The number of samples in the input and output buffer
+	 * @param events The events, sorted by offset
+	 * @param nEvents The number of events
+	 */
+	template<typename T>
+	void processEvents(T *input, double l, T *output, int nFrames, const ParameterEvent *events, int nEvents);
 public:
 	/**
 	 * Default constructor. Defaults to peak value mode with 
@@ -103,6 +142,14 @@ public:
 	void setGainPc(double g){gain = g;}
 	void setGaindB(double g){gain = dBtoPc(g);}
 
+	/**
+	 * setFastMath selects the approximations of FastMath for the
+	 * dB conversions instead of pow and log10.
+	 * @param f IFF true the conversions use FastMath
+	 * @see FastMath.h
+	 */
+	void setFastMath(bool f){fastMath = f;}
+
 	/***** Getters For User Parameters *****/
 	unsigned int getMode(){return mode;}
 	double getFs(){return Fs;}
@@ -125,6 +172,7 @@ public:
 	double getRelMod(){return relMod;}
 	double getkMod(){return kMod;}
 	double getEffRatio(){return effRatio;}
+	bool getFastMath(){return fastMath;}
 
 	/**
 	 * setParamsPc provides an interface to simultaneously update all parameters of the dynamics modifier.
@@ -190,7 +238,10 @@ public:
 	 * @param dB The decibel value to be converted
 	 * @return A double containing the percentage.
 	 */
-	double dBtoPc(double dB){return pow(10, dB/20);}
+	double dBtoPc(double dB){
+		if(fastMath) return fastdBToGain(dB);
+		return pow(10, dB/20);
+	}
 
 	/**
 	 * PcTodB is a helper function to convert from percentages
@@ -198,7 +249,10 @@ public:
 	 * @param Pc The percentage value to convert
 	 * @return The corresponding dB value
 	 */
-	double PcTodB(double Pc){return 20*log10(Pc);	}
+	double PcTodB(double Pc){
+		if(fastMath) return fastGainTodB(Pc);
+		return 20*log10(Pc);
+	}
 
 	/**
 	 * getBufferLevel determines which averaging algorithm
@@ -208,8 +262,8 @@ public:
 	 * @see Averages
 	 * @return The average level of the input buffer
 	 */
-
-	double getBufferLevel(double *input, int nFrames);
+	template<typename T>
+	double getBufferLevel(T *input, int nFrames);
 
 	/**
 	 * processBuffer applies the compression to an input
@@ -226,7 +280,68 @@ public:
 	 * @param output Pass by call output buffer
 	 * @param nFrames The number of samples in the input and output buffer
 	 */
-	void Dynamics::processBuffer(double *input, double *sideChain, double *output, int nFrames);
+	void processBuffer(double *input, double *sideChain, double *output, int nFrames);
+
+	/**
+	 * processBuffer applies the compression to a float32 input
+	 * @param input The input sample buffer
+	 * @param output Pass by call output buffer
+	 * @param nFrames The number of samples in the input and output buffer
+	 */
+	void processBuffer(float *input, float *output, int nFrames);
+
+	/**
+	 * processBuffer applies the compression to a float32 input
+	 * @param input The input sample buffer
+	 * @param sideChain The input buffer for a sidechain
+	 * @param output Pass by call output buffer
+	 * @param nFrames The number of samples in the input and output buffer
+	 */
+	void processBuffer(float *input, float *sideChain, float *output, int nFrames);
+
+	/**
+	 * Parameter ids of the events given to processBuffer.
+	 * THRESH_PARAM: threshold in %
+	 * RATIO_PARAM: ratio
+	 * ATK_PARAM: attack in samples, at least 1
+	 * REL_PARAM: release in samples, at least 1
+	 * KNEE_PARAM: knee in %
+	 * GAIN_PARAM: makeup gain in %
+	 */
+	enum{THRESH_PARAM = 0, RATIO_PARAM = 1, ATK_PARAM = 2, REL_PARAM = 3, KNEE_PARAM = 4, GAIN_PARAM = 5};
+
+	/**
+	 * processBuffer applies the compression while applying the
+	 * parameter changes of an event list at their sample offsets.
+	 * The buffer is split at the offsets and every sub-block runs
+	 * the normal processing loop.
+	 * @param input The input sample buffer
+	 * @param output Pass by call output buffer
+	 * @param nFrames The number of samples in the input and output buffer
+	 * @param events The events, sorted by offset
+	 * @param nEvents The number of events
+	 * @see ParameterEvent
+	 */
+	void processBuffer(double *input, double *output, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * Sidechain version of the event list processBuffer
+	 * @param sideChain The input buffer for a sidechain
+	 * @see processBuffer(double*, double*, int, const ParameterEvent*, int)
+	 */
+	void processBuffer(double *input, double *sideChain, double *output, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * Float version of the event list processBuffer
+	 * @see processBuffer(double*, double*, int, const ParameterEvent*, int)
+	 */
+	void processBuffer(float *input, float *output, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * Float sidechain version of the event list processBuffer
+	 * @see processBuffer(double*, double*, double*, int, const ParameterEvent*, int)
+	 */
+	void processBuffer(float *input, float *sideChain, float *output, int nFrames, const ParameterEvent *events, int nEvents);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,260 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+//include
+#include <cstring>
+#include <stdint.h>
+
+/**
+ * FastMath provides polynomial approximations of the libm
+ * functions used to design filters and convert gains. They are
+ * branch free (except fastSinh) and inline so that loops calling
+ * them can be vectorized by the compiler. Maximum errors measured
+ * over the documented ranges are given with each function.
+ * sqrt is not approximated: it is a single instruction already.
+ * @author Ryan Khan Logan
+ */
+
+#define FM_PI 3.14159265358979323846
+#define FM_TWOPI 6.28318530717958647692
+#define FM_INVTWOPI 0.15915494309189533577
+#define FM_HALFPI 1.57079632679489661923
+#define FM_LOG2E 1.44269504088896340736
+#define FM_LOG2_10 3.32192809488736234787
+#define FM_LOG10_2 0.30102999566398119521
+
+/**
+ * fastRound rounds to the nearest integer value
+ * @param x The value to round. |x| must be below 2^51
+ * @return x rounded to the nearest integer, as a double
+ */
+inline double fastRound(double x){
+	const double magic = 6755399441055744.0;	//2^52 + 2^51
+	return (x + magic) - magic;
+}
+
+/**
+ * fastSin approximates sin(x) with a degree 13 odd polynomial
+ * after reducing x to [-pi/2, pi/2].
+ * Max absolute error: 7e-10 for |x| <= 1e4
+ * @param x The angle in radians
+ * @return sin(x)
+ */
+inline double fastSin(double x){
+	//reduce to [-pi, pi]
+	x -= FM_TWOPI * fastRound(x * FM_INVTWOPI);
+	//fold to [-pi/2, pi/2] using sin(pi - x) = sin(x)
+	double s = x > FM_HALFPI ? FM_PI - x : x;
+	s = s < -FM_HALFPI ? -FM_PI - s : s;
+
+	double s2 = s * s;
+	double p = 1.0 / 6227020800.0;
+	p = p * s2 - 1.0 / 39916800.0;
+	p = p * s2 + 1.0 / 362880.0;
+	p = p * s2 - 1.0 / 5040.0;
+	p = p * s2 + 1.0 / 120.0;
+	p = p * s2 - 1.0 / 6.0;
+	p = p * s2 + 1.0;
+	return s * p;
+}
+
+/**
+ * fastCos approximates cos(x) through fastSin
+ * Max absolute error: 7e-10 for |x| <= 1e4
+ * @param x The angle in radians
+ * @return cos(x)
+ * @see fastSin()
+ */
+inline double fastCos(double x){
+	return fastSin(x + FM_HALFPI);
+}
+
+/**
+ * fastTan approximates tan(x) as fastSin(x) / fastCos(x)
+ * Max relative error: 1e-9 for |x| <= 1.5, growing as x
+ * approaches pi/2
+ * @param x The angle in radians
+ * @return tan(x)
+ * @see fastSin()
+ * @see fastCos()
+ */
+inline double fastTan(double x){
+	return fastSin(x) / fastCos(x);
+}
+
+/**
+ * fastExp2 approximates 2^x. The exponent is split into an
+ * integer part, applied directly to the exponent bits, and a
+ * fraction in [-0.5, 0.5] approximated with a degree 9
+ * polynomial.
+ * Max relative error: 1e-11 for |x| <= 1000
+ * @param x The exponent
+ * @return 2^x
+ */
+inline double fastExp2(double x){
+	double n = fastRound(x);
+	double f = (x - n) * 0.69314718055994530942;
+
+	double p = 1.0 / 362880.0;
+	p = p * f + 1.0 / 40320.0;
+	p = p * f + 1.0 / 5040.0;
+	p = p * f + 1.0 / 720.0;
+	p = p * f + 1.0 / 120.0;
+	p = p * f + 1.0 / 24.0;
+	p = p * f + 1.0 / 6.0;
+	p = p * f + 0.5;
+	p = p * f + 1.0;
+	p = p * f + 1.0;
+
+	//scale by 2^n
+	int64_t bits = (int64_t)(n + 1023) << 52;
+	double scale;
+	memcpy(&scale, &bits, sizeof(double));
+	return p * scale;
+}
+
+/**
+ * fastExp approximates e^x through fastExp2
+ * Max relative error: 1e-11 for |x| <= 700
+ * @param x The exponent
+ * @return e^x
+ */
+inline double fastExp(double x){
+	return fastExp2(x * FM_LOG2E);
+}
+
+/**
+ * fastLog2 approximates log2(x). The exponent is read from
+ * the bits of x and the log of the mantissa, reduced to
+ * [sqrt(1/2), sqrt(2)], is computed with the atanh series.
+ * Max absolute error: 3e-11 for normal positive x
+ * @param x A positive normal number
+ * @return log2(x)
+ */
+inline double fastLog2(double x){
+	int64_t bits;
+	memcpy(&bits, &x, sizeof(double));
+	int64_t e = ((bits >> 52) & 0x7ff) - 1023;
+	bits = (bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL;
+	double m;
+	memcpy(&m, &bits, sizeof(double));
+
+	//reduce the mantissa to [sqrt(1/2), sqrt(2)]
+	double big = m > 1.41421356237309504880 ? 1.0 : 0.0;
+	m *= 1.0 - 0.5 * big;
+	double t = (m - 1) / (m + 1);
+	double t2 = t * t;
+
+	double p = 1.0 / 11.0;
+	p = p * t2 + 1.0 / 9.0;
+	p = p * t2 + 1.0 / 7.0;
+	p = p * t2 + 1.0 / 5.0;
+	p = p * t2 + 1.0 / 3.0;
+	p = p * t2 + 1.0;
+	return (double)e + big + 2 * FM_LOG2E * t * p;
+}
+
+/**
+ * fastPow10 approximates 10^x through fastExp2
+ * Max relative error: 1e-11 for |x| <= 300
+ * @param x The exponent
+ * @return 10^x
+ */
+inline double fastPow10(double x){
+	return fastExp2(x * FM_LOG2_10);
+}
+
+/**
+ * fastLog10 approximates log10(x) through fastLog2
+ * Max absolute error: 1e-11 for normal positive x
+ * @param x A positive normal number
+ * @return log10(x)
+ */
+inline double fastLog10(double x){
+	return fastLog2(x) * FM_LOG10_2;
+}
+
+/**
+ * fastSinh approximates sinh(x). Small arguments use the
+ * Taylor series to avoid the cancellation of (e^x - e^-x) / 2.
+ * Max relative error: 2e-11 for |x| <= 700
+ * @param x The argument
+ * @return sinh(x)
+ */
+inline double fastSinh(double x){
+	if(x < 0.5 && x > -0.5){
+		double x2 = x * x;
+		double p = 1.0 / 39916800.0;
+		p = p * x2 + 1.0 / 362880.0;
+		p = p * x2 + 1.0 / 5040.0;
+		p = p * x2 + 1.0 / 120.0;
+		p = p * x2 + 1.0 / 6.0;
+		p = p * x2 + 1.0;
+		return x * p;
+	}
+	double e = fastExp(x);
+	return 0.5 * (e - 1 / e);
+}
+
+/**
+ * fastAtan2 approximates atan2(y, x). The ratio of the smaller to
+ * the larger magnitude is reduced to [-tan(pi/8), tan(pi/8)] with
+ * atan(a) = pi/4 + atan((a-1)/(a+1)) and evaluated with the
+ * Taylor series up to t^21, then moved to the right octant.
+ * Max absolute error: 1e-10
+ * @param y The ordinate
+ * @param x The abscissa
+ * @return The angle of (x, y) in [-pi, pi]
+ */
+inline double fastAtan2(double y, double x){
+	double ax = x < 0 ? -x : x;
+	double ay = y < 0 ? -y : y;
+	double mx = ax > ay ? ax : ay;
+	double mn = ax > ay ? ay : ax;
+	double a = mx > 0 ? mn / mx : 0;
+
+	//reduce to |t| <= tan(pi/8)
+	bool big = a > 0.41421356237309504880;
+	double t = big ? (a - 1) / (a + 1) : a;
+	double t2 = t * t;
+
+	double p = 1.0 / 21.0;
+	p = 1.0 / 19.0 - p * t2;
+	p = 1.0 / 17.0 - p * t2;
+	p = 1.0 / 15.0 - p * t2;
+	p = 1.0 / 13.0 - p * t2;
+	p = 1.0 / 11.0 - p * t2;
+	p = 1.0 / 9.0 - p * t2;
+	p = 1.0 / 7.0 - p * t2;
+	p = 1.0 / 5.0 - p * t2;
+	p = 1.0 / 3.0 - p * t2;
+	p = 1.0 - p * t2;
+	double r = t * p + (big ? FM_PI / 4 : 0);
+
+	//back to the full circle
+	r = ay > ax ? FM_HALFPI - r : r;
+	r = x < 0 ? FM_PI - r : r;
+	return y < 0 ? -r : r;
+}
+
+/**
+ * fastdBToGain converts a value in dB to a linear gain,
+ * 10^(dB/20)
+ * Max relative error: 1e-11 for |dB| <= 6000
+ * @param dB The value in dB
+ * @return The linear gain
+ */
+inline double fastdBToGain(double dB){
+	return fastExp2(dB * (FM_LOG2_10 / 20));
+}
+
+/**
+ * fastGainTodB converts a linear gain to dB, 20*log10(g)
+ * Max absolute error: 2e-10 dB for normal positive g
+ * @param g The linear gain
+ * @return The value in dB
+ */
+inline double fastGainTodB(double g){
+	return fastLog2(g) * (20 * FM_LOG10_2);
+}
+#endif
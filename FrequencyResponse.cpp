@@ -0,0 +1,238 @@
+#include "FrequencyResponse.h"
+#include "FastMath.h"
+
+/**
+ * Creates an evaluator for a grid of frequencies
+ * @param fs The sample rate in Hz
+ * @param freqs The frequencies in Hz
+ * @param n The number of frequencies
+ */
+FrequencyResponse::FrequencyResponse(double fs, double *freqs, int n){
+	nPoints = 0;
+	cosTable = 0;
+	sinTable = 0;
+	nBands = 0;
+	bands = 0;
+	bandCoFs = 0;
+	bandMags = 0;
+	bandPhases = 0;
+	setFrequencies(fs, freqs, n);
+}
+
+FrequencyResponse::~FrequencyResponse(){
+	delete[] cosTable;
+	delete[] sinTable;
+	delete[] bands;
+	delete[] bandCoFs;
+	delete[] bandMags;
+	delete[] bandPhases;
+}
+
+/**
+ * setFrequencies changes the grid and rebuilds the tables.
+ * Band responses of the incremental mode are recomputed on
+ * the next update.
+ * @param fs The sample rate in Hz
+ * @param freqs The frequencies in Hz
+ * @param n The number of frequencies
+ */
+void FrequencyResponse::setFrequencies(double fs, double *freqs, int n){
+	if(n != nPoints){
+		delete[] cosTable;
+		delete[] sinTable;
+		cosTable = new double[4 * n];
+		sinTable = new double[4 * n];
+		nPoints = n;
+		//band buffers depend on nPoints
+		setBands(bands, nBands);
+	}
+	Fs = fs;
+
+	for(int i = 0; i < nPoints; i++){
+		double w = 2 * M_PI * freqs[i] / Fs;
+		for(int k = 0; k < 4; k++){
+			cosTable[k * nPoints + i] = cos((k + 1) * w);
+			sinTable[k * nPoints + i] = sin((k + 1) * w);
+		}
+	}
+
+	//force a full update
+	for(int b = 0; b < nBands; b++) bandCoFs[5 * b] = NAN;
+}
+
+/**
+ * evaluateSection computes the response of a normalized
+ * 2nd order section. If accumulate is set, the magnitude is
+ * multiplied into mag and the phase is added to phase.
+ * @param b The b coFs, b0 b1 b2
+ * @param a The a coFs, a1 a2 (a0 = 1)
+ * @param mag Pass by call magnitudes of size nPoints
+ * @param phase Pass by call phases of size nPoints, or 0
+ * @param accumulate IFF true the result is combined with mag and phase
+ */
+void FrequencyResponse::evaluateSection(double *b, double *a, double *mag, double *phase, bool accumulate){
+	double b0 = b[0], b1 = b[1], b2 = b[2];
+	double a1 = a[0], a2 = a[1];
+	double *c1 = cosTable, *c2 = cosTable + nPoints;
+	double *s1 = sinTable, *s2 = sinTable + nPoints;
+
+	//H(e^jw) = N / D with z^-k = cos(kw) - j sin(kw)
+	for(int i = 0; i < nPoints; i++){
+		double nr = b0 + b1 * c1[i] + b2 * c2[i];
+		double ni = -(b1 * s1[i] + b2 * s2[i]);
+		double dr = 1 + a1 * c1[i] + a2 * c2[i];
+		double di = -(a1 * s1[i] + a2 * s2[i]);
+		double m = sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+		mag[i] = accumulate ? mag[i] * m : m;
+	}
+
+	if(phase == 0) return;
+	for(int i = 0; i < nPoints; i++){
+		double nr = b0 + b1 * c1[i] + b2 * c2[i];
+		double ni = -(b1 * s1[i] + b2 * s2[i]);
+		double dr = 1 + a1 * c1[i] + a2 * c2[i];
+		double di = -(a1 * s1[i] + a2 * s2[i]);
+		//arg(N / D) = arg(N * conj(D))
+		double p = fastAtan2(ni * dr - nr * di, nr * dr + ni * di);
+		phase[i] = accumulate ? phase[i] + p : p;
+	}
+}
+
+/**
+ * evaluate4 computes the response of a normalized 4th order
+ * filter.
+ * @param b The numerator coFs, b0 to b4
+ * @param a The denominator coFs, a1 to a4 (a0 = 1)
+ * @param mag Pass by call magnitudes of size nPoints
+ * @param phase Pass by call phases of size nPoints, or 0
+ */
+void FrequencyResponse::evaluate4(double *b, double *a, double *mag, double *phase){
+	for(int i = 0; i < nPoints; i++){
+		double nr = b[0], ni = 0;
+		double dr = 1, di = 0;
+		for(int k = 0; k < 4; k++){
+			double c = cosTable[k * nPoints + i];
+			double s = sinTable[k * nPoints + i];
+			nr += b[k+1] * c;
+			ni -= b[k+1] * s;
+			dr += a[k] * c;
+			di -= a[k] * s;
+		}
+		mag[i] = sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+		if(phase != 0) phase[i] = fastAtan2(ni * dr - nr * di, nr * dr + ni * di);
+	}
+}
+
+/**
+ * evaluate computes the response of a Biquad
+ * @param f The filter
+ * @param mag Pass by call magnitudes of size nPoints
+ * @param phase Pass by call phases of size nPoints, or 0 to skip the phase
+ */
+void FrequencyResponse::evaluate(Biquad &f, double *mag, double *phase){
+	double as[3], bs[3];
+	f.getNormCoFs(as, bs);
+	evaluateSection(bs, as + 1, mag, phase, false);
+}
+
+/**
+ * evaluate computes the response of the active sections of
+ * a cascade
+ * @param c The cascade
+ * @param mag Pass by call magnitudes of size nPoints
+ * @param phase Pass by call phases of size nPoints, or 0 to skip the phase
+ */
+void FrequencyResponse::evaluate(BiquadCascade &c, double *mag, double *phase){
+	for(int i = 0; i < nPoints; i++){
+		mag[i] = 1;
+		if(phase != 0) phase[i] = 0;
+	}
+	for(int s = 0; s < c.getNumSections(); s++){
+		if(c.isBypassed(s)) continue;
+		double as[3], bs[3];
+		c.getSection(s)->getNormCoFs(as, bs);
+		evaluateSection(bs, as + 1, mag, phase, true);
+	}
+}
+
+/**
+ * evaluate computes the response of both outputs of a
+ * LinkwitzRiley crossover. Any of the phase buffers may be 0.
+ * @param lr The crossover
+ * @param lowMag Pass by call magnitudes of the low pass
+ * @param lowPhase Pass by call phases of the low pass
+ * @param hiMag Pass by call magnitudes of the high pass
+ * @param hiPhase Pass by call phases of the high pass
+ */
+void FrequencyResponse::evaluate(LinkwitzRiley &lr, double *lowMag, double *lowPhase, double *hiMag, double *hiPhase){
+	double bs[4], las[5], has[5];
+	lr.getCoFs(bs, las, has);
+	evaluate4(las, bs, lowMag, lowPhase);
+	evaluate4(has, bs, hiMag, hiPhase);
+}
+
+/**
+ * setBands selects the filters of the incremental mode. The
+ * filters are not owned and must outlive the evaluator.
+ * @param b The filters, applied in series
+ * @param n The number of filters
+ */
+void FrequencyResponse::setBands(Biquad **b, int n){
+	Biquad **old = bands;
+	bands = new Biquad*[n];
+	for(int i = 0; i < n; i++) bands[i] = b[i];
+	delete[] old;
+
+	delete[] bandCoFs;
+	delete[] bandMags;
+	delete[] bandPhases;
+	nBands = n;
+	bandCoFs = new double[5 * nBands];
+	bandMags = new double[nBands * nPoints];
+	bandPhases = new double[nBands * nPoints];
+
+	//NaN never compares equal, so every band is computed once
+	for(int i = 0; i < nBands; i++) bandCoFs[5 * i] = NAN;
+}
+
+/**
+ * update computes the response of the bands given to
+ * setBands, recomputing only the bands whose coFs changed
+ * since the last update.
+ * @param mag Pass by call magnitudes of size nPoints
+ * @param phase Pass by call phases of size nPoints, or 0 to skip the phase
+ * @return The number of bands that were recomputed
+ */
+int FrequencyResponse::update(double *mag, double *phase){
+	int nChanged = 0;
+
+	for(int b = 0; b < nBands; b++){
+		double as[3], bs[3];
+		double *last = bandCoFs + 5 * b;
+		bands[b]->getNormCoFs(as, bs);
+		if(last[0] == bs[0] && last[1] == bs[1] && last[2] == bs[2]
+				&& last[3] == as[1] && last[4] == as[2]) continue;
+
+		last[0] = bs[0];
+		last[1] = bs[1];
+		last[2] = bs[2];
+		last[3] = as[1];
+		last[4] = as[2];
+		//the phase is always kept so that it is ready when asked for
+		evaluateSection(bs, as + 1, bandMags + b * nPoints, bandPhases + b * nPoints, false);
+		nChanged++;
+	}
+
+	for(int i = 0; i < nPoints; i++){
+		mag[i] = 1;
+		if(phase != 0) phase[i] = 0;
+	}
+	for(int b = 0; b < nBands; b++){
+		double *m = bandMags + b * nPoints;
+		for(int i = 0; i < nPoints; i++) mag[i] *= m[i];
+		if(phase == 0) continue;
+		double *p = bandPhases + b * nPoints;
+		for(int i = 0; i < nPoints; i++) phase[i] += p[i];
+	}
+	return nChanged;
+}
@@ -0,0 +1,127 @@
+#ifndef FREQUENCYRESPONSE_H
+#define FREQUENCYRESPONSE_H
+
+//include
+#include "Biquad.h"
+#include "BiquadCascade.h"
+#include "LinkwitzRiley.h"
+
+/**
+ * FrequencyResponse evaluates the magnitude and phase of filters
+ * on a fixed grid of frequencies, for example the points of an
+ * EQ display. cos(kw) and sin(kw) are tabulated once per grid so
+ * that an evaluation is a branch free loop of multiply-adds over
+ * the points, which the compiler vectorizes. Magnitudes are
+ * linear and phases are in radians.
+ * An optional incremental mode keeps the response of a set of
+ * bands and only recomputes the bands whose coFs changed.
+ * @see Biquad
+ * @see BiquadCascade
+ * @see LinkwitzRiley
+ */
+class FrequencyResponse{
+protected:
+	double Fs;
+	int nPoints;
+	double *cosTable;			//cos(k w) for k = 1..4, 4 rows of nPoints
+	double *sinTable;			//sin(k w) for k = 1..4, 4 rows of nPoints
+
+	//incremental mode
+	int nBands;
+	Biquad **bands;
+	double *bandCoFs;			//last normalized coFs of each band, 5 per band
+	double *bandMags;			//response of each band, nPoints per band
+	double *bandPhases;
+
+	/**
+	 * evaluateSection computes the response of a normalized
+	 * 2nd order section. If accumulate is set, the magnitude is
+	 * multiplied into mag and the phase is added to phase.
+	 * @param b The b coFs, b0 b1 b2
+	 * @param a The a coFs, a1 a2 (a0 = 1)
+	 * @param mag Pass by call magnitudes of size nPoints
+	 * @param phase Pass by call phases of size nPoints, or 0
+	 * @param accumulate IFF true the result is combined with mag and phase
+	 */
+	void evaluateSection(double *b, double *a, double *mag, double *phase, bool accumulate);
+
+	/**
+	 * evaluate4 computes the response of a normalized 4th order
+	 * filter.
+	 * @param b The numerator coFs, b0 to b4
+	 * @param a The denominator coFs, a1 to a4 (a0 = 1)
+	 * @param mag Pass by call magnitudes of size nPoints
+	 * @param phase Pass by call phases of size nPoints, or 0
+	 */
+	void evaluate4(double *b, double *a, double *mag, double *phase);
+
+public:
+	/**
+	 * Creates an evaluator for a grid of frequencies
+	 * @param fs The sample rate in Hz
+	 * @param freqs The frequencies in Hz
+	 * @param n The number of frequencies
+	 */
+	FrequencyResponse(double fs, double *freqs, int n);
+
+	~FrequencyResponse();
+
+	/**
+	 * setFrequencies changes the grid and rebuilds the tables.
+	 * Band responses of the incremental mode are recomputed on
+	 * the next update.
+	 * @param fs The sample rate in Hz
+	 * @param freqs The frequencies in Hz
+	 * @param n The number of frequencies
+	 */
+	void setFrequencies(double fs, double *freqs, int n);
+
+	int getNumPoints(){return nPoints;}
+
+	/**
+	 * evaluate computes the response of a Biquad
+	 * @param f The filter
+	 * @param mag Pass by call magnitudes of size nPoints
+	 * @param phase Pass by call phases of size nPoints, or 0 to skip the phase
+	 */
+	void evaluate(Biquad &f, double *mag, double *phase);
+
+	/**
+	 * evaluate computes the response of the active sections of
+	 * a cascade
+	 * @param c The cascade
+	 * @param mag Pass by call magnitudes of size nPoints
+	 * @param phase Pass by call phases of size nPoints, or 0 to skip the phase
+	 */
+	void evaluate(BiquadCascade &c, double *mag, double *phase);
+
+	/**
+	 * evaluate computes the response of both outputs of a
+	 * LinkwitzRiley crossover. Any of the phase buffers may be 0.
+	 * @param lr The crossover
+	 * @param lowMag Pass by call magnitudes of the low pass
+	 * @param lowPhase Pass by call phases of the low pass
+	 * @param hiMag Pass by call magnitudes of the high pass
+	 * @param hiPhase Pass by call phases of the high pass
+	 */
+	void evaluate(LinkwitzRiley &lr, double *lowMag, double *lowPhase, double *hiMag, double *hiPhase);
+
+	/**
+	 * setBands selects the filters of the incremental mode. The
+	 * filters are not owned and must outlive the evaluator.
+	 * @param b The filters, applied in series
+	 * @param n The number of filters
+	 */
+	void setBands(Biquad **b, int n);
+
+	/**
+	 * update computes the response of the bands given to
+	 * setBands, recomputing only the bands whose coFs changed
+	 * since the last update.
+	 * @param mag Pass by call magnitudes of size nPoints
+	 * @param phase Pass by call phases of size nPoints, or 0 to skip the phase
+	 * @return The number of bands that were recomputed
+	 */
+	int update(double *mag, double *phase);
+};
+#endif
@@ -1,16 +1,26 @@
 #include "LinkwitzRiley.h"
+#include "FastMath.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 LinkwitzRiley::LinkwitzRiley(){
+	fastMath = false;
 	updateParams(44100.0, 440.0);
-
-	x4 = 0; x3 = 0; x2 = 0; x1 = 0;
-	h4 = 0; h3 = 0; h2 = 0; h1 = 0;
-	l4 = 0; l3 = 0; l2 = 0; l1 = 0;
+	initHist();
 }
 
 LinkwitzRiley::LinkwitzRiley(double fs, double f){
+	fastMath = false;
 	updateParams(fs, f);
+	initHist();
+}
 
+/**
+ * initHist clears the history of both outputs
+ */
+void LinkwitzRiley::initHist(){
 	x4 = 0; x3 = 0; x2 = 0; x1 = 0;
 	h4 = 0; h3 = 0; h2 = 0; h1 = 0;
 	l4 = 0; l3 = 0; l2 = 0; l1 = 0;
@@ -28,6 +38,17 @@ bool LinkwitzRiley::setFc(double f){
 	return true;
 }
 
+/**
+ * setFastMath selects the polynomial approximation of tan from
+ * FastMath instead of libm. The coFs are recomputed.
+ * @param f IFF true the design uses FastMath
+ * @see FastMath.h
+ */
+void LinkwitzRiley::setFastMath(bool f){
+	fastMath = f;
+	updateParams(-1, -1);
+}
+
 void LinkwitzRiley::getBs(double *b){
 	b[0] = b1;
 	b[1] = b2;
@@ -65,7 +86,8 @@ void LinkwitzRiley::updateParams(double fs, double f){
 	w4 = w2 * w2;
 
 	//computer intermediate params
-	c1 = w0 / (tan(M_PI * fc / Fs));
+	if(fastMath) c1 = w0 / (fastTan(M_PI * fc / Fs));
+	else c1 = w0 / (tan(M_PI * fc / Fs));
 	c2 = c1 * c1;
 	c3 = c2 * c1;
 	c4 = c2 * c2;
@@ -96,22 +118,118 @@ void LinkwitzRiley::updateParams(double fs, double f){
 	ha4 = ha0;
 }
 
-void LinkwitzRiley::processBuffer(double *input, double *low, double *hi, int nFrames){
+/**
+ * processSamples is the processing core shared by the double
+ * and float versions of processBuffer. The 4th order
+ * recursion is not stable in single precision at low
+ * crossover frequencies, so the coFs and the history stay
+ * double and only the buffers use the sample type T.
+ * With SSE2 the low pass and the high pass are computed together
+ * in the two lanes of a vector: lane 0 holds the LP coFs and
+ * history, lane 1 the HP ones, and the shared b1..b4 and x1..x4
+ * are broadcast to both lanes.
+ * @see processBuffer()
+ */
+template<typename T>
+void LinkwitzRiley::processSamples(T *input, T *low, T *hi, int nFrames){
+	ScopedNoDenormals noDenormals;
+#if defined(__SSE2__) || defined(_M_X64)
+	__m128d a0 = _mm_set_pd(ha0, la0), a1 = _mm_set_pd(ha1, la1);
+	__m128d a2 = _mm_set_pd(ha2, la2), a3 = _mm_set_pd(ha3, la3);
+	__m128d a4 = _mm_set_pd(ha4, la4);
+	__m128d vb1 = _mm_set1_pd(b1), vb2 = _mm_set1_pd(b2);
+	__m128d vb3 = _mm_set1_pd(b3), vb4 = _mm_set1_pd(b4);
+	__m128d vx1 = _mm_set1_pd(x1), vx2 = _mm_set1_pd(x2);
+	__m128d vx3 = _mm_set1_pd(x3), vx4 = _mm_set1_pd(x4);
+	__m128d y1 = _mm_set_pd(h1, l1), y2 = _mm_set_pd(h2, l2);
+	__m128d y3 = _mm_set_pd(h3, l3), y4 = _mm_set_pd(h4, l4);
+
+	for(int i = 0; i < nFrames; i++){
+		__m128d vx0 = _mm_set1_pd((double)input[i]);
+
+		//everything but the last output first, to shorten the recursion
+		__m128d ff = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0, vx0), _mm_mul_pd(a1, vx1)),
+			_mm_add_pd(_mm_mul_pd(a2, vx2), _mm_mul_pd(a3, vx3)));
+		__m128d fb = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vb2, y2), _mm_mul_pd(vb3, y3)),
+			_mm_mul_pd(vb4, y4));
+		__m128d acc = _mm_sub_pd(_mm_add_pd(ff, _mm_mul_pd(a4, vx4)), fb);
+		__m128d y0 = _mm_sub_pd(acc, _mm_mul_pd(vb1, y1));
+
+		low[i] = (T)_mm_cvtsd_f64(y0);
+		hi[i] = (T)_mm_cvtsd_f64(_mm_unpackhi_pd(y0, y0));
+
+		//update histories
+		vx4 = vx3; vx3 = vx2; vx2 = vx1; vx1 = vx0;
+		y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+	}
+
+	x1 = _mm_cvtsd_f64(vx1); x2 = _mm_cvtsd_f64(vx2);
+	x3 = _mm_cvtsd_f64(vx3); x4 = _mm_cvtsd_f64(vx4);
+	l1 = _mm_cvtsd_f64(y1); h1 = _mm_cvtsd_f64(_mm_unpackhi_pd(y1, y1));
+	l2 = _mm_cvtsd_f64(y2); h2 = _mm_cvtsd_f64(_mm_unpackhi_pd(y2, y2));
+	l3 = _mm_cvtsd_f64(y3); h3 = _mm_cvtsd_f64(_mm_unpackhi_pd(y3, y3));
+	l4 = _mm_cvtsd_f64(y4); h4 = _mm_cvtsd_f64(_mm_unpackhi_pd(y4, y4));
+#else
 	for(int i = 0; i < nFrames; i++){
 		double x0 = input[i];
 
 		//process lowpass
-		low[i] = la0*x0 + la1*x1 + la2*x2 +la3*x3 + la4*x4;
-		low[i] = low[i] - b1*l1 - b2*l2 - b3*l3 - b4*l4;
-		
+		double lo = la0*x0 + la1*x1 + la2*x2 +la3*x3 + la4*x4;
+		lo = lo - b1*l1 - b2*l2 - b3*l3 - b4*l4;
 
 		//process hipass
-		hi[i]= ha0*x0 + ha1*x1 + ha2*x2 + ha3*x3 + ha4*x4;
-		hi[i]= hi[i] - b1*h1 - b2*h2 - b3*h3 - b4*h4;
-		
+		double hp = ha0*x0 + ha1*x1 + ha2*x2 + ha3*x3 + ha4*x4;
+		hp = hp - b1*h1 - b2*h2 - b3*h3 - b4*h4;
+
+		low[i] = (T)lo;
+		hi[i] = (T)hp;
+
 		//update histories
 		x4 = x3; x3 = x2; x2 = x1; x1 = x0;
-		l4 = l3; l3 = l2; l2 = l1; l1 = low[i];
-		h4 = h3; h3 = h2; h2 = h1; h1 = hi[i];
+		l4 = l3; l3 = l2; l2 = l1; l1 = lo;
+		h4 = h3; h3 = h2; h2 = h1; h1 = hp;
+	}
+#endif
+
+	if(noDenormals.needsFlush()){
+		Denormals::flush(l1); Denormals::flush(l2);
+		Denormals::flush(l3); Denormals::flush(l4);
+		Denormals::flush(h1); Denormals::flush(h2);
+		Denormals::flush(h3); Denormals::flush(h4);
 	}
 }
+
+void LinkwitzRiley::processBuffer(double *input, double *low, double *hi, int nFrames){
+	processSamples(input, low, hi, nFrames);
+}
+
+void LinkwitzRiley::processBuffer(float *input, float *low, float *hi, int nFrames){
+	processSamples(input, low, hi, nFrames);
+}
+
+/**
+ * processEvents is the core of the event list processBuffer. Only
+ * the last frequency of the events sharing an offset is designed.
+ * @see splitAtEvents()
+ * @see processBuffer(double*, double*, double*, int, const ParameterEvent*, int)
+ */
+template<typename T>
+void LinkwitzRiley::processEvents(T *input, T *low, T *hi, int nFrames, const ParameterEvent *events, int nEvents){
+	double f = -1;
+	splitAtEvents(events, nEvents, nFrames,
+		[&f](const ParameterEvent &ev){
+			if(ev.param != FC_PARAM || ev.value <= 0) return false;
+			f = ev.value;
+			return true;
+		},
+		[this, &f](){updateParams(-1, f);},
+		[this, input, low, hi](int pos, int n){processSamples(input + pos, low + pos, hi + pos, n);});
+}
+
+void LinkwitzRiley::processBuffer(double *input, double *low, double *hi, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, low, hi, nFrames, events, nEvents);
+}
+
+void LinkwitzRiley::processBuffer(float *input, float *low, float *hi, int nFrames, const ParameterEvent *events, int nEvents){
+	processEvents(input, low, hi, nFrames, events, nEvents);
+}
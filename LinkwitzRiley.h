@@ -1,6 +1,10 @@
 #ifndef LINKWITZRILEY_H
 #define LINKWITZRILEY_H
 
+#include <cmath>
+#include "Denormals.h"
+#include "ParameterEvent.h"
+
 //global paramters
 #define M_PI 3.14159265359
 #define LN2 0.69314718056
@@ -24,6 +28,26 @@ private:
 	double h4, h3, h2, h1;
 	double l4, l3, l2, l1;
 
+	bool fastMath;				//true IFF the design uses FastMath
+
+	/**
+	 * processSamples is the processing core shared by the double
+	 * and float versions of processBuffer. The 4th order
+	 * recursion is not stable in single precision at low
+	 * crossover frequencies, so the coFs and the history stay
+	 * double and only the buffers use the sample type T.
+	 * @see processBuffer()
+	 */
+	template<typename T>
+	void processSamples(T *input, T *low, T *hi, int nFrames);
+
+	/**
+	 * processEvents is the core of the event list processBuffer.
+	 * @see processBuffer(double*, double*, double*, int, const ParameterEvent*, int)
+	 */
+	template<typename T>
+	void processEvents(T *input, T *low, T *hi, int nFrames, const ParameterEvent *events, int nEvents);
+
 public:
 	LinkwitzRiley();
 	LinkwitzRiley(double fs, double f);
@@ -40,8 +64,51 @@ public:
 	void getCoFs(double *bs, double *las, double *has);
 	double getOmega0(){return w0;}
 
+	/**
+	 * setFastMath selects the polynomial approximation of tan from
+	 * FastMath instead of libm. The coFs are recomputed.
+	 * @param f IFF true the design uses FastMath
+	 * @see FastMath.h
+	 */
+	void setFastMath(bool f);
+	bool getFastMath(){return fastMath;}
+
 	void updateParams(double fs, double f);
 
+	/**
+	 * initHist clears the history of both outputs
+	 */
+	void initHist();
+
 	void processBuffer(double *input, double *low, double *hi, int nFrames);
+
+	void processBuffer(float *input, float *low, float *hi, int nFrames);
+
+	/**
+	 * Parameter ids of the events given to processBuffer.
+	 * FC_PARAM: crossover frequency in Hz
+	 */
+	enum{FC_PARAM = 0};
+
+	/**
+	 * processBuffer splits the input while applying the parameter
+	 * changes of an event list at their sample offsets. The
+	 * buffer is cut at the offsets and the coFs are updated once
+	 * between sub-blocks.
+	 * @param input The input buffer
+	 * @param low The low band output buffer
+	 * @param hi The high band output buffer
+	 * @param nFrames The number of samples in the buffers
+	 * @param events The events, sorted by offset
+	 * @param nEvents The number of events
+	 * @see ParameterEvent
+	 */
+	void processBuffer(double *input, double *low, double *hi, int nFrames, const ParameterEvent *events, int nEvents);
+
+	/**
+	 * Float version of the event list processBuffer
+	 * @see processBuffer(double*, double*, double*, int, const ParameterEvent*, int)
+	 */
+	void processBuffer(float *input, float *low, float *hi, int nFrames, const ParameterEvent *events, int nEvents);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,267 @@
+#include "LinkwitzRileyBank.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Creates a crossover for n channels
+ * @param n The number of channels
+ * @param fs The sample rate
+ * @param f The crossover frequency
+ */
+LinkwitzRileyBank::LinkwitzRileyBank(int n, double fs, double f) : designer(fs, f){
+	nChannels = n;
+
+	//one block for all the SoA arrays
+	x1 = new double[12 * nChannels];
+	x2 = x1 + nChannels;
+	x3 = x2 + nChannels;
+	x4 = x3 + nChannels;
+	l1 = x4 + nChannels;
+	l2 = l1 + nChannels;
+	l3 = l2 + nChannels;
+	l4 = l3 + nChannels;
+	h1 = l4 + nChannels;
+	h2 = h1 + nChannels;
+	h3 = h2 + nChannels;
+	h4 = h3 + nChannels;
+
+	loadCoFs();
+	initHist();
+}
+
+LinkwitzRileyBank::~LinkwitzRileyBank(){
+	delete[] x1;
+}
+
+/**
+ * loadCoFs copies the coFs of the designer
+ */
+void LinkwitzRileyBank::loadCoFs(){
+	double bs[4];
+	double las[5];
+	double has[5];
+	designer.getCoFs(bs, las, has);
+
+	b1 = bs[0];
+	b2 = bs[1];
+	b3 = bs[2];
+	b4 = bs[3];
+	la0 = las[0];
+	la1 = las[1];
+	la2 = las[2];
+	ha0 = has[0];
+	ha1 = has[1];
+	ha2 = has[2];
+}
+
+bool LinkwitzRileyBank::setFs(double fs){
+	if(!designer.setFs(fs)) return false;
+	loadCoFs();
+	return true;
+}
+
+bool LinkwitzRileyBank::setFc(double f){
+	if(!designer.setFc(f)) return false;
+	loadCoFs();
+	return true;
+}
+
+/**
+ * setFastMath selects FastMath for the design of the coFs
+ * @param f IFF true the design uses FastMath
+ * @see LinkwitzRiley::setFastMath()
+ */
+void LinkwitzRileyBank::setFastMath(bool f){
+	designer.setFastMath(f);
+	loadCoFs();
+}
+
+/**
+ * initHist clears the history of every channel
+ */
+void LinkwitzRileyBank::initHist(){
+	for(int i = 0; i < 12 * nChannels; i++) x1[i] = 0;
+}
+
+/**
+ * processBuffer splits every channel into a low and a high
+ * band. Channel i reads input[i] and writes low[i] and hi[i].
+ * @param input Array of nChannels input buffers of size nFrames
+ * @param low Array of nChannels low band buffers of size nFrames
+ * @param hi Array of nChannels high band buffers of size nFrames
+ * @param nFrames The number of samples in each buffer
+ */
+void LinkwitzRileyBank::processBuffer(double **input, double **low, double **hi, int nFrames){
+	ScopedNoDenormals noDenormals;
+	int c = 0;
+	//full vectors
+	for(; c + BANK_WIDTH <= nChannels && BANK_WIDTH > 1; c += BANK_WIDTH){
+		processGroup(c, input, low, hi, nFrames);
+	}
+	//remaining channels
+	for(; c < nChannels; c++){
+		processChannel(c, input[c], low[c], hi[c], nFrames);
+	}
+
+	if(noDenormals.needsFlush()){
+		for(c = 0; c < nChannels; c++){
+			Denormals::flush(l1[c]); Denormals::flush(l2[c]);
+			Denormals::flush(l3[c]); Denormals::flush(l4[c]);
+			Denormals::flush(h1[c]); Denormals::flush(h2[c]);
+			Denormals::flush(h3[c]); Denormals::flush(h4[c]);
+		}
+	}
+}
+
+/**
+ * processGroup filters BANK_WIDTH consecutive channels with
+ * vector instructions. The symmetric feedforward coFs are
+ * applied to x0 + x4 and x1 + x3, which are shared by the LP and
+ * the HP.
+ * @param g The first channel of the group
+ * @param input Array of nChannels input buffers
+ * @param low Array of nChannels low band output buffers
+ * @param hi Array of nChannels high band output buffers
+ * @param nFrames The number of samples in each buffer
+ */
+void LinkwitzRileyBank::processGroup(int g, double **input, double **low, double **hi, int nFrames){
+#if defined(__AVX__)
+	double *in0 = input[g], *in1 = input[g+1], *in2 = input[g+2], *in3 = input[g+3];
+	__m256d vb1 = _mm256_set1_pd(b1), vb2 = _mm256_set1_pd(b2);
+	__m256d vb3 = _mm256_set1_pd(b3), vb4 = _mm256_set1_pd(b4);
+	__m256d vla0 = _mm256_set1_pd(la0), vla1 = _mm256_set1_pd(la1), vla2 = _mm256_set1_pd(la2);
+	__m256d vha0 = _mm256_set1_pd(ha0), vha1 = _mm256_set1_pd(ha1), vha2 = _mm256_set1_pd(ha2);
+	__m256d vx1 = _mm256_loadu_pd(x1 + g), vx2 = _mm256_loadu_pd(x2 + g);
+	__m256d vx3 = _mm256_loadu_pd(x3 + g), vx4 = _mm256_loadu_pd(x4 + g);
+	__m256d vl1 = _mm256_loadu_pd(l1 + g), vl2 = _mm256_loadu_pd(l2 + g);
+	__m256d vl3 = _mm256_loadu_pd(l3 + g), vl4 = _mm256_loadu_pd(l4 + g);
+	__m256d vh1 = _mm256_loadu_pd(h1 + g), vh2 = _mm256_loadu_pd(h2 + g);
+	__m256d vh3 = _mm256_loadu_pd(h3 + g), vh4 = _mm256_loadu_pd(h4 + g);
+	double y[4];
+
+	for(int i = 0; i < nFrames; i++){
+		__m256d vx0 = _mm256_set_pd(in3[i], in2[i], in1[i], in0[i]);
+		__m256d s04 = _mm256_add_pd(vx0, vx4);
+		__m256d s13 = _mm256_add_pd(vx1, vx3);
+
+		__m256d lo = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vla0, s04), _mm256_mul_pd(vla1, s13)), _mm256_mul_pd(vla2, vx2));
+		lo = _mm256_sub_pd(lo, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vb2, vl2), _mm256_mul_pd(vb3, vl3)), _mm256_mul_pd(vb4, vl4)));
+		lo = _mm256_sub_pd(lo, _mm256_mul_pd(vb1, vl1));
+
+		__m256d hp = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vha0, s04), _mm256_mul_pd(vha1, s13)), _mm256_mul_pd(vha2, vx2));
+		hp = _mm256_sub_pd(hp, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vb2, vh2), _mm256_mul_pd(vb3, vh3)), _mm256_mul_pd(vb4, vh4)));
+		hp = _mm256_sub_pd(hp, _mm256_mul_pd(vb1, vh1));
+
+		_mm256_storeu_pd(y, lo);
+		low[g][i] = y[0]; low[g+1][i] = y[1]; low[g+2][i] = y[2]; low[g+3][i] = y[3];
+		_mm256_storeu_pd(y, hp);
+		hi[g][i] = y[0]; hi[g+1][i] = y[1]; hi[g+2][i] = y[2]; hi[g+3][i] = y[3];
+
+		//update histories
+		vx4 = vx3; vx3 = vx2; vx2 = vx1; vx1 = vx0;
+		vl4 = vl3; vl3 = vl2; vl2 = vl1; vl1 = lo;
+		vh4 = vh3; vh3 = vh2; vh2 = vh1; vh1 = hp;
+	}
+
+	_mm256_storeu_pd(x1 + g, vx1); _mm256_storeu_pd(x2 + g, vx2);
+	_mm256_storeu_pd(x3 + g, vx3); _mm256_storeu_pd(x4 + g, vx4);
+	_mm256_storeu_pd(l1 + g, vl1); _mm256_storeu_pd(l2 + g, vl2);
+	_mm256_storeu_pd(l3 + g, vl3); _mm256_storeu_pd(l4 + g, vl4);
+	_mm256_storeu_pd(h1 + g, vh1); _mm256_storeu_pd(h2 + g, vh2);
+	_mm256_storeu_pd(h3 + g, vh3); _mm256_storeu_pd(h4 + g, vh4);
+#elif defined(__SSE2__) || defined(_M_X64)
+	double *in0 = input[g], *in1 = input[g+1];
+	double *lo0 = low[g], *lo1 = low[g+1];
+	double *hi0 = hi[g], *hi1 = hi[g+1];
+	__m128d vb1 = _mm_set1_pd(b1), vb2 = _mm_set1_pd(b2);
+	__m128d vb3 = _mm_set1_pd(b3), vb4 = _mm_set1_pd(b4);
+	__m128d vla0 = _mm_set1_pd(la0), vla1 = _mm_set1_pd(la1), vla2 = _mm_set1_pd(la2);
+	__m128d vha0 = _mm_set1_pd(ha0), vha1 = _mm_set1_pd(ha1), vha2 = _mm_set1_pd(ha2);
+	__m128d vx1 = _mm_loadu_pd(x1 + g), vx2 = _mm_loadu_pd(x2 + g);
+	__m128d vx3 = _mm_loadu_pd(x3 + g), vx4 = _mm_loadu_pd(x4 + g);
+	__m128d vl1 = _mm_loadu_pd(l1 + g), vl2 = _mm_loadu_pd(l2 + g);
+	__m128d vl3 = _mm_loadu_pd(l3 + g), vl4 = _mm_loadu_pd(l4 + g);
+	__m128d vh1 = _mm_loadu_pd(h1 + g), vh2 = _mm_loadu_pd(h2 + g);
+	__m128d vh3 = _mm_loadu_pd(h3 + g), vh4 = _mm_loadu_pd(h4 + g);
+
+	for(int i = 0; i < nFrames; i++){
+		__m128d vx0 = _mm_set_pd(in1[i], in0[i]);
+		__m128d s04 = _mm_add_pd(vx0, vx4);
+		__m128d s13 = _mm_add_pd(vx1, vx3);
+
+		__m128d lo = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vla0, s04), _mm_mul_pd(vla1, s13)), _mm_mul_pd(vla2, vx2));
+		lo = _mm_sub_pd(lo, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vb2, vl2), _mm_mul_pd(vb3, vl3)), _mm_mul_pd(vb4, vl4)));
+		lo = _mm_sub_pd(lo, _mm_mul_pd(vb1, vl1));
+
+		__m128d hp = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vha0, s04), _mm_mul_pd(vha1, s13)), _mm_mul_pd(vha2, vx2));
+		hp = _mm_sub_pd(hp, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vb2, vh2), _mm_mul_pd(vb3, vh3)), _mm_mul_pd(vb4, vh4)));
+		hp = _mm_sub_pd(hp, _mm_mul_pd(vb1, vh1));
+
+		_mm_storel_pd(lo0 + i, lo);
+		_mm_storeh_pd(lo1 + i, lo);
+		_mm_storel_pd(hi0 + i, hp);
+		_mm_storeh_pd(hi1 + i, hp);
+
+		//update histories
+		vx4 = vx3; vx3 = vx2; vx2 = vx1; vx1 = vx0;
+		vl4 = vl3; vl3 = vl2; vl2 = vl1; vl1 = lo;
+		vh4 = vh3; vh3 = vh2; vh2 = vh1; vh1 = hp;
+	}
+
+	_mm_storeu_pd(x1 + g, vx1); _mm_storeu_pd(x2 + g, vx2);
+	_mm_storeu_pd(x3 + g, vx3); _mm_storeu_pd(x4 + g, vx4);
+	_mm_storeu_pd(l1 + g, vl1); _mm_storeu_pd(l2 + g, vl2);
+	_mm_storeu_pd(l3 + g, vl3); _mm_storeu_pd(l4 + g, vl4);
+	_mm_storeu_pd(h1 + g, vh1); _mm_storeu_pd(h2 + g, vh2);
+	_mm_storeu_pd(h3 + g, vh3); _mm_storeu_pd(h4 + g, vh4);
+#else
+	for(int c = g; c < g + BANK_WIDTH; c++){
+		processChannel(c, input[c], low[c], hi[c], nFrames);
+	}
+#endif
+}
+
+/**
+ * processChannel filters a single channel with scalar code.
+ * Used for the channels that do not fill a complete vector.
+ * @param c The channel to process
+ * @param input The input buffer of the channel
+ * @param low The low band output buffer of the channel
+ * @param hi The high band output buffer of the channel
+ * @param nFrames The number of samples in the buffers
+ */
+void LinkwitzRileyBank::processChannel(int c, double *input, double *low, double *hi, int nFrames){
+	double cx1 = x1[c], cx2 = x2[c], cx3 = x3[c], cx4 = x4[c];
+	double cl1 = l1[c], cl2 = l2[c], cl3 = l3[c], cl4 = l4[c];
+	double ch1 = h1[c], ch2 = h2[c], ch3 = h3[c], ch4 = h4[c];
+
+	for(int i = 0; i < nFrames; i++){
+		double x0 = input[i];
+		double s04 = x0 + cx4;
+		double s13 = cx1 + cx3;
+
+		double lo = la0*s04 + la1*s13 + la2*cx2;
+		lo = lo - (b2*cl2 + b3*cl3 + b4*cl4);
+		lo = lo - b1*cl1;
+
+		double hp = ha0*s04 + ha1*s13 + ha2*cx2;
+		hp = hp - (b2*ch2 + b3*ch3 + b4*ch4);
+		hp = hp - b1*ch1;
+
+		low[i] = lo;
+		hi[i] = hp;
+
+		//update histories
+		cx4 = cx3; cx3 = cx2; cx2 = cx1; cx1 = x0;
+		cl4 = cl3; cl3 = cl2; cl2 = cl1; cl1 = lo;
+		ch4 = ch3; ch3 = ch2; ch2 = ch1; ch1 = hp;
+	}
+
+	x1[c] = cx1; x2[c] = cx2; x3[c] = cx3; x4[c] = cx4;
+	l1[c] = cl1; l2[c] = cl2; l3[c] = cl3; l4[c] = cl4;
+	h1[c] = ch1; h2[c] = ch2; h3[c] = ch3; h4[c] = ch4;
+}
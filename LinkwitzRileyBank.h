@@ -0,0 +1,105 @@
+#ifndef LINKWITZRILEYBANK_H
+#define LINKWITZRILEYBANK_H
+
+//include
+#include "LinkwitzRiley.h"
+#include "BiquadBank.h"				//BANK_WIDTH
+
+/**
+ * LinkwitzRileyBank applies the same Linkwitz-Riley crossover to
+ * several channels. The coFs are designed once and shared by every
+ * channel, and the history of each channel is stored in
+ * structure-of-arrays layout so that BANK_WIDTH channels are
+ * computed by each SSE/AVX instruction. The buffers are planar:
+ * one buffer per channel.
+ * @see LinkwitzRiley
+ * @see BiquadBank
+ */
+class LinkwitzRileyBank{
+protected:
+	int nChannels;				//number of channels
+	LinkwitzRiley designer;		//designs the shared coFs
+
+	//shared coFs
+	double b1, b2, b3, b4;
+	double la0, la1, la2;		//LP coFs, la3 = la1 and la4 = la0
+	double ha0, ha1, ha2;		//HP coFs, ha3 = ha1 and ha4 = ha0
+
+	//history, one entry per channel
+	double *x1, *x2, *x3, *x4;
+	double *l1, *l2, *l3, *l4;
+	double *h1, *h2, *h3, *h4;
+
+	/**
+	 * loadCoFs copies the coFs of the designer
+	 */
+	void loadCoFs();
+
+	/**
+	 * processGroup filters BANK_WIDTH consecutive channels with
+	 * vector instructions.
+	 * @param g The first channel of the group
+	 * @param input Array of nChannels input buffers
+	 * @param low Array of nChannels low band output buffers
+	 * @param hi Array of nChannels high band output buffers
+	 * @param nFrames The number of samples in each buffer
+	 */
+	void processGroup(int g, double **input, double **low, double **hi, int nFrames);
+
+	/**
+	 * processChannel filters a single channel with scalar code.
+	 * Used for the channels that do not fill a complete vector.
+	 * @param c The channel to process
+	 * @param input The input buffer of the channel
+	 * @param low The low band output buffer of the channel
+	 * @param hi The high band output buffer of the channel
+	 * @param nFrames The number of samples in the buffers
+	 */
+	void processChannel(int c, double *input, double *low, double *hi, int nFrames);
+
+public:
+	/**
+	 * Creates a crossover for n channels
+	 * @param n The number of channels
+	 * @param fs The sample rate
+	 * @param f The crossover frequency
+	 */
+	LinkwitzRileyBank(int n, double fs, double f);
+
+	~LinkwitzRileyBank();
+
+	//not copyable, a copy would free the state block twice
+	LinkwitzRileyBank(const LinkwitzRileyBank &) = delete;
+	LinkwitzRileyBank &operator=(const LinkwitzRileyBank &) = delete;
+
+	bool setFs(double fs);
+
+	bool setFc(double f);
+
+	double getFs(){return designer.getFs();}
+	double getFc(){return designer.getFc();}
+	int getNumChannels(){return nChannels;}
+
+	/**
+	 * setFastMath selects FastMath for the design of the coFs
+	 * @param f IFF true the design uses FastMath
+	 * @see LinkwitzRiley::setFastMath()
+	 */
+	void setFastMath(bool f);
+
+	/**
+	 * initHist clears the history of every channel
+	 */
+	void initHist();
+
+	/**
+	 * processBuffer splits every channel into a low and a high
+	 * band. Channel i reads input[i] and writes low[i] and hi[i].
+	 * @param input Array of nChannels input buffers of size nFrames
+	 * @param low Array of nChannels low band buffers of size nFrames
+	 * @param hi Array of nChannels high band buffers of size nFrames
+	 * @param nFrames The number of samples in each buffer
+	 */
+	void processBuffer(double **input, double **low, double **hi, int nFrames);
+};
+#endif
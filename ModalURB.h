@@ -2,25 +2,247 @@
 #define MODALURB_H
 
 //include
-#include "Biquad.h"
-#include "ModalURB.h"
+#include "ResonatorBank.h"
 
+//number of modes of the default model
+#define MODAL_MODES 8
+//default size of the voice pool
+#define MODAL_VOICES 16
+//fade out of a stolen voice in seconds
+#define MODAL_STEAL_FADE 0.005
+
+/**
+ * ModalVoice holds the state of one note of ModalURB. The
+ * resonators of the voice are a range of lanes of the engine's
+ * ResonatorBank.
+ */
+struct ModalVoice{
+	bool active;				//true IFF the voice is playing
+	bool excite;				//true until the impulse has been rendered
+	double f0;					//fundamental of the note
+	double amp;					//velocity gain
+	double env;					//current gain of the linear envelope
+	double envStep;				//envelope decrease per sample
+	int start;					//first sample to render in the next block
+	unsigned long age;			//note number, to find the oldest voice
+	int lane;					//first resonator of the voice
+	int nModes;					//number of modes below Nyquist
+};
+
+/**
+ * ModalURB is a polyphonic modal synthesizer. Each note excites
+ * band pass resonators tuned to ratios of its fundamental, given
+ * by a mode table of up to maxModes entries (the URB model of
+ * MODAL_MODES modes by default). The resonators of all the voices
+ * live in one ResonatorBank that renders and sums them in vector
+ * lanes. The voices come from a fixed size pool and the bank is
+ * allocated by the constructor, so noteOn, noteOff and
+ * processBuffer never allocate memory and can be called from the
+ * audio thread. When the pool is full the quietest voice is
+ * stolen: its note is moved to a shadow voice that fades it out
+ * over MODAL_STEAL_FADE seconds, so stealing does not click.
+ * processBuffer renders blocks of any size.
+ */
 class ModalURB{
 protected:
 	double Fs;
-	double f0;
-	Biquad filters[8];
-	double freqs[8];
-	double amps[8];
-	double bws[8]
+	double f0;					//fundamental of the last note
+
+	//mode table, maxModes entries of which nModes are used
+	int maxModes;
+	int nModes;
+	double *ratios;				//mode frequency / fundamental
+	double *amps;				//mode gains
+	double *bws;				//mode bandwidths in octaves
+	double *freqs;				//mode frequencies of the last note
+
+	int nVoices;				//size of the voice pool
+	ModalVoice *voices;
+	ModalVoice *fades;			//shadow voices, fading out the stolen notes
+	unsigned long noteCounter;	//number of notes started
+	int voiceLanes;				//resonators per voice, a multiple of BANK_WIDTH
+	ResonatorBank *bank;		//resonators of all the voices
+
+	int noteLength;				//envelope length in samples
+	int releaseLength;			//release length in samples
+	int stealLength;			//fade out length of a stolen note in samples
+
+	ModalVoice offline;			//voice used by generateNote
+	ModalVoice stream;			//voice used by startNote and streamNote
+
+	/**
+	 * initVoice clears a voice and gives it its resonators
+	 * @param v The voice
+	 * @param lane The first resonator of the voice
+	 */
+	void initVoice(ModalVoice &v, int lane);
+
+	/**
+	 * startVoice tunes a voice to a note and restarts its envelope
+	 * @param v The voice
+	 * @param f The fundamental of the note
+	 * @param a The velocity gain of the note
+	 * @param offset The sample of the next block where the note starts
+	 * @return false IFF f is not positive, the voice is then unchanged
+	 */
+	bool startVoice(ModalVoice &v, double f, double a, int offset);
+
+	/**
+	 * renderVoice adds the next nFrames samples of a voice to the
+	 * output. The voice is freed when its envelope reaches 0.
+	 * @param v The voice
+	 * @param output The output buffer
+	 * @param nFrames The number of samples
+	 */
+	void renderVoice(ModalVoice &v, double *output, int nFrames);
 
 public:
+	/**
+	 * Creates an engine with MODAL_VOICES voices
+	 * @param fs The sample rate
+	 */
 	ModalURB(double fs);
+
+	/**
+	 * Creates an engine
+	 * @param fs The sample rate
+	 * @param n The number of voices
+	 * @param m The largest number of modes of the mode table
+	 */
+	ModalURB(double fs, int n, int m = MODAL_MODES);
+
+	~ModalURB();
+
+	//not copyable, a copy would free the voices and the bank twice
+	ModalURB(const ModalURB &) = delete;
+	ModalURB &operator=(const ModalURB &) = delete;
+
 	double getFs(){return Fs;}
 	double getF0(){return f0;}
-	void updateParams(double f);
+	int getNumVoices(){return nVoices;}
+	int getNumModes(){return nModes;}
+	int getMaxModes(){return maxModes;}
+
+	/**
+	 * getNumActive counts the voices playing
+	 * @return The number of active voices
+	 */
+	int getNumActive();
+
+	/**
+	 * updateFreqs computes the mode frequencies of a note
+	 * @param f The fundamental of the note
+	 */
 	void updateFreqs(double f);
-	void generateNote(double f, double *output, int nFrames)
+
+	/**
+	 * setModes replaces the mode table. The playing voices keep
+	 * their modes, the new table is used by the next notes.
+	 * @param r The frequency ratios of the modes to the fundamental
+	 * @param a The gains of the modes
+	 * @param b The bandwidths of the modes in octaves
+	 * @param n The number of modes
+	 * @return false IFF n is above the maximum given to the constructor
+	 * or a ratio or a bandwidth is not positive. The table is then unchanged.
+	 */
+	bool setModes(const double *r, const double *a, const double *b, int n);
+
+	/**
+	 * getModeHash hashes the mode table, so that notes rendered
+	 * with different tables can be told apart.
+	 * @return A 64 bit FNV-1a hash of the used entries of the table
+	 * @see NoteCache
+	 */
+	unsigned long long getModeHash();
+
+	/**
+	 * setNoteLength sets the length of the linear decay of the notes
+	 * @param s The length in seconds
+	 */
+	void setNoteLength(double s);
+
+	/**
+	 * setRelease sets the fade out applied by noteOff
+	 * @param s The length in seconds
+	 */
+	void setRelease(double s);
+
+	/**
+	 * noteOn starts a note. If no voice is free the quietest one
+	 * is stolen and its note faded out by a free shadow voice.
+	 * If every shadow voice is fading, the quietest fade is cut.
+	 * @param f The fundamental of the note in Hz
+	 * @param a The velocity gain of the note
+	 * @param offset The sample of the next block where the note starts
+	 * @return The voice playing the note, or -1 if f is not positive
+	 */
+	int noteOn(double f, double a, int offset = 0);
+
+	/**
+	 * noteOff releases every voice playing the fundamental f
+	 * @param f The fundamental of the note in Hz
+	 */
+	void noteOff(double f);
+
+	/**
+	 * allNotesOff stops every voice immediately
+	 */
+	void allNotesOff();
+
+	/**
+	 * processBuffer renders the next block of every active voice.
+	 * @param output The output buffer, overwritten
+	 * @param nFrames The number of samples, any size
+	 */
+	void processBuffer(double *output, int nFrames);
+
+	/**
+	 * generateNote renders a whole note offline with a linear
+	 * envelope over nFrames. It uses its own voice, so neither the
+	 * playing voices nor the note of startNote are affected. The note is silent if f is
+	 * not positive, and nothing is rendered if nFrames is below 1.
+	 * @param f The fundamental of the note
+	 * @param output The output buffer
+	 * @param nFrames The length of the note in samples
+	 */
+	void generateNote(double f, double *output, int nFrames);
+
+	/**
+	 * startNote starts a note on the stream voice, to be rendered
+	 * block by block with streamNote. The stream voice has its own
+	 * resonators, so the pool, noteOn and generateNote do not affect
+	 * it: it renders one note alone, e.g. to export it without a
+	 * buffer of its whole length.
+	 * @param f The fundamental of the note
+	 * @param a The velocity gain of the note
+	 * @param nFrames The length of the envelope in samples, or 0 for
+	 * the length set in seconds by setNoteLength. A note of nFrames
+	 * samples is the same as the one of generateNote.
+	 * @return false IFF f is not positive or nFrames is negative
+	 */
+	bool startNote(double f, double a = 1, int nFrames = 0);
+
+	/**
+	 * stopNote releases the note started by startNote over the
+	 * length set by setRelease
+	 */
+	void stopNote();
+
+	/**
+	 * isNotePlaying
+	 * @return true IFF the note started by startNote has samples left
+	 */
+	bool isNotePlaying(){return stream.active;}
+
+	/**
+	 * streamNote renders the next block of the note started by
+	 * startNote. The cost of a block only depends on its size.
+	 * @param output The output buffer, overwritten
+	 * @param nFrames The number of samples
+	 * @return The number of samples of the block before the end of
+	 * the note, the rest is silent; 0 once the note is over
+	 */
+	int streamNote(double *output, int nFrames);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,254 @@
+#include "NoteBank.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char NOTEBANK_MAGIC[8] = {'M', 'U', 'R', 'B', 'B', 'A', 'N', 'K'};
+
+NoteBank::NoteBank(){
+	header = 0;
+	data = 0;
+	size = 0;
+#ifdef _WIN32
+	file = 0;
+	mapping = 0;
+#endif
+}
+
+/**
+ * Unmaps the file
+ */
+NoteBank::~NoteBank(){
+	close();
+}
+
+/**
+ * bake renders notes offline and writes them to a bank file.
+ * The samples are converted to float, and every note is padded
+ * to a multiple of NOTEBANK_ALIGN bytes.
+ * @param path The file to write
+ * @param layers The synthesizers of the layers, softest first
+ * @param layerVel The highest velocity (0 - 1) of each layer
+ * @param nLayers The number of layers, at most NOTEBANK_MAX_LAYERS
+ * @param firstNote The MIDI number of the lowest note
+ * @param nNotes The number of notes
+ * @param nFrames The length of every note in samples
+ * @return false IFF the arguments are invalid or the file could not be written
+ */
+bool NoteBank::bake(const char *path, ModalURB **layers, const float *layerVel, int nLayers,
+	int firstNote, int nNotes, int nFrames){
+	if(nLayers < 1 || nLayers > NOTEBANK_MAX_LAYERS || nNotes < 1 || nFrames < 1) return false;
+	for(int l = 1; l < nLayers; l++){
+		if(layers[l]->getFs() != layers[0]->getFs()) return false;
+	}
+
+	NoteBankHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, NOTEBANK_MAGIC, sizeof(h.magic));
+	h.version = NOTEBANK_VERSION;
+	h.dataOffset = NOTEBANK_DATA_OFFSET;
+	h.Fs = layers[0]->getFs();
+	h.modeHash = layers[0]->getModeHash();
+	h.firstNote = firstNote;
+	h.nNotes = nNotes;
+	h.nLayers = nLayers;
+	h.length = nFrames;
+	h.stride = (nFrames * sizeof(float) + NOTEBANK_ALIGN - 1) / NOTEBANK_ALIGN * NOTEBANK_ALIGN;
+	for(int l = 0; l < nLayers; l++) h.layerVel[l] = layerVel[l];
+
+	FILE *f = fopen(path, "wb");
+	if(!f) return false;
+
+	char *pad = new char[NOTEBANK_DATA_OFFSET];
+	memset(pad, 0, NOTEBANK_DATA_OFFSET);
+	memcpy(pad, &h, sizeof(h));
+	bool ok = fwrite(pad, 1, NOTEBANK_DATA_OFFSET, f) == NOTEBANK_DATA_OFFSET;
+	delete[] pad;
+
+	int strideFloats = (int)(h.stride / sizeof(float));
+	double *note = new double[nFrames];
+	float *samples = new float[strideFloats];
+	for(int i = nFrames; i < strideFloats; i++) samples[i] = 0;
+	for(int n = 0; n < nNotes && ok; n++){
+		double f0 = 440 * pow(2.0, (firstNote + n - 69) / 12.0);
+		for(int l = 0; l < nLayers && ok; l++){
+			layers[l]->generateNote(f0, note, nFrames);
+			for(int i = 0; i < nFrames; i++) samples[i] = (float)note[i];
+			ok = fwrite(samples, sizeof(float), strideFloats, f) == (size_t)strideFloats;
+		}
+	}
+	delete[] note;
+	delete[] samples;
+
+	if(fclose(f) != 0) ok = false;
+	if(!ok) remove(path);
+	return ok;
+}
+
+/**
+ * validate checks a mapped header against the size of the file
+ * @return true IFF the header is of this version and the notes fit in the file
+ */
+bool NoteBank::validate(){
+	if(size < NOTEBANK_DATA_OFFSET) return false;
+	if(memcmp(header->magic, NOTEBANK_MAGIC, sizeof(header->magic)) != 0) return false;
+	if(header->version != NOTEBANK_VERSION || header->dataOffset != NOTEBANK_DATA_OFFSET) return false;
+	if(header->nNotes < 1 || header->nLayers < 1 || header->nLayers > NOTEBANK_MAX_LAYERS) return false;
+	if(header->length < 1 || header->stride < header->length * sizeof(float)) return false;
+	if(header->stride % NOTEBANK_ALIGN != 0) return false;
+	//divide rather than multiply, the stride is read from the file and may overflow
+	uint64_t notes = (uint64_t)header->nNotes * header->nLayers;
+	return header->stride <= (size - NOTEBANK_DATA_OFFSET) / notes;
+}
+
+/**
+ * open maps a bank file read only. Nothing is read but the
+ * header, the other pages are faulted in on first use.
+ * @param path The file
+ * @return false IFF the file could not be mapped or is not a valid bank
+ */
+bool NoteBank::open(const char *path){
+	close();
+#ifdef _WIN32
+	HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, 0);
+	if(fh == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(fh, &fileSize) || fileSize.QuadPart < NOTEBANK_DATA_OFFSET){
+		CloseHandle(fh);
+		return false;
+	}
+	HANDLE mh = CreateFileMappingA(fh, 0, PAGE_READONLY, 0, 0, 0);
+	if(!mh){
+		CloseHandle(fh);
+		return false;
+	}
+	void *p = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+	if(!p){
+		CloseHandle(mh);
+		CloseHandle(fh);
+		return false;
+	}
+	file = fh;
+	mapping = mh;
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0) return false;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < NOTEBANK_DATA_OFFSET){
+		::close(fd);
+		return false;
+	}
+	void *p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	//the mapping keeps the file open
+	::close(fd);
+	if(p == MAP_FAILED) return false;
+	//the notes are read in no particular order, do not read ahead
+	madvise(p, (size_t)st.st_size, MADV_RANDOM);
+	size = (size_t)st.st_size;
+#endif
+	header = (const NoteBankHeader*)p;
+	data = (const char*)p + NOTEBANK_DATA_OFFSET;
+	if(!validate()){
+		close();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * close unmaps the file. The pointers given by getNote become invalid.
+ */
+void NoteBank::close(){
+	if(!header) return;
+#ifdef _WIN32
+	UnmapViewOfFile((LPCVOID)header);
+	CloseHandle((HANDLE)mapping);
+	CloseHandle((HANDLE)file);
+	file = 0;
+	mapping = 0;
+#else
+	munmap((void*)header, size);
+#endif
+	header = 0;
+	data = 0;
+	size = 0;
+}
+
+/**
+ * getLayer finds the layer of a velocity
+ * @param velocity The velocity, 0 - 1
+ * @return The softest layer whose highest velocity is not below velocity
+ */
+int NoteBank::getLayer(double velocity){
+	if(!header) return 0;
+	for(int l = 0; l < header->nLayers - 1; l++){
+		if(velocity <= header->layerVel[l]) return l;
+	}
+	return header->nLayers - 1;
+}
+
+/**
+ * getNote points at the samples of a note in the mapping
+ * @param note The MIDI number of the note
+ * @param layer The velocity layer
+ * @return The getLength() samples of the note, or 0 if it is not in the bank
+ */
+const float *NoteBank::getNote(int note, int layer){
+	if(!header) return 0;
+	int n = note - header->firstNote;
+	if(n < 0 || n >= header->nNotes || layer < 0 || layer >= header->nLayers) return 0;
+	return (const float*)(data + ((size_t)n * header->nLayers + layer) * header->stride);
+}
+
+/**
+ * prefetch asks the system to read the pages of a note ahead,
+ * e.g. on note on, so that the first blocks do not fault. It
+ * only gives advice and returns at once.
+ * @param note The MIDI number of the note
+ * @param layer The velocity layer
+ */
+void NoteBank::prefetch(int note, int layer){
+	const float *p = getNote(note, layer);
+	if(!p) return;
+#ifdef _WIN32
+	//PrefetchVirtualMemory needs Windows 8, the pages are faulted in on first read
+	(void)p;
+#else
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)p / page * page;
+	uintptr_t end = (uintptr_t)(p + header->length);
+	madvise((void*)start, end - start, MADV_WILLNEED);
+#endif
+}
+
+/**
+ * readNote adds a block of a note, scaled by a gain, to a
+ * buffer. The block is cut at the end of the note.
+ * @param note The MIDI number of the note
+ * @param layer The velocity layer
+ * @param pos The first sample of the note to read
+ * @param gain The gain applied to the samples
+ * @param output The buffer the samples are added to
+ * @param nFrames The number of samples
+ * @return The number of samples added, 0 once the note is over
+ */
+int NoteBank::readNote(int note, int layer, int pos, double gain, double *output, int nFrames){
+	const float *p = getNote(note, layer);
+	if(!p || pos < 0 || pos >= header->length) return 0;
+	int n = header->length - pos;
+	if(n > nFrames) n = nFrames;
+	p += pos;
+	for(int i = 0; i < n; i++) output[i] += gain * p[i];
+	return n;
+}
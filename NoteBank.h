@@ -0,0 +1,152 @@
+#ifndef NOTEBANK_H
+#define NOTEBANK_H
+
+//include
+#include <stdint.h>
+#include <cstddef>
+#include "ModalURB.h"
+
+#define NOTEBANK_VERSION 1
+//alignment of every note in the file, a cache line
+#define NOTEBANK_ALIGN 64
+//offset of the first note, so that the notes are page aligned in the mapping
+#define NOTEBANK_DATA_OFFSET 4096
+#define NOTEBANK_MAX_LAYERS 8
+
+/**
+ * Header of a note bank file. The file is this header, padded
+ * to NOTEBANK_DATA_OFFSET bytes, followed by nNotes * nLayers
+ * notes of length 32 bit float samples, each one stride bytes
+ * long. Note n, layer l starts at
+ * NOTEBANK_DATA_OFFSET + (n * nLayers + l) * stride.
+ * Everything is stored in the byte order of the machine that
+ * baked it; a file of the other order fails the version check.
+ * @see NoteBank
+ */
+struct NoteBankHeader{
+	char magic[8];							//"MURBBANK"
+	uint32_t version;						//NOTEBANK_VERSION
+	uint32_t dataOffset;					//NOTEBANK_DATA_OFFSET
+	double Fs;
+	uint64_t modeHash;						//@see ModalURB::getModeHash, of layer 0
+	int32_t firstNote;						//MIDI number of note 0
+	int32_t nNotes;
+	int32_t nLayers;
+	int32_t length;							//samples per note
+	uint64_t stride;						//bytes per note, a multiple of NOTEBANK_ALIGN
+	float layerVel[NOTEBANK_MAX_LAYERS];	//highest velocity (0 - 1) of each layer
+};
+
+/**
+ * NoteBank plays notes prerendered by ModalURB from a memory
+ * mapped file. bake renders every note of a range of MIDI pitches
+ * once, offline, for one or more velocity layers. open maps the
+ * file read only without touching its pages, so opening a bank
+ * is near-instant whatever its size: the pages of a note are
+ * faulted in when it is first read, or ahead of time by prefetch.
+ * The samples are used in place, so reading a note never decodes
+ * it nor allocates memory.
+ * @see ModalURB
+ */
+class NoteBank{
+protected:
+	const NoteBankHeader *header;	//start of the mapping, 0 when closed
+	const char *data;				//first note
+	size_t size;					//size of the mapping
+
+#ifdef _WIN32
+	void *file;						//HANDLE of the file
+	void *mapping;					//HANDLE of the file mapping
+#endif
+
+	/**
+	 * validate checks a mapped header against the size of the file
+	 * @return true IFF the header is of this version and the notes fit in the file
+	 */
+	bool validate();
+
+public:
+	NoteBank();
+
+	/**
+	 * Unmaps the file
+	 */
+	~NoteBank();
+
+	//not copyable, a copy would unmap the mapping twice
+	NoteBank(const NoteBank &) = delete;
+	NoteBank &operator=(const NoteBank &) = delete;
+
+	/**
+	 * bake renders notes offline and writes them to a bank file.
+	 * Each velocity layer is rendered by its own synthesizer, so the
+	 * layers can differ by their mode tables. Every synthesizer must
+	 * have the sample rate of the first one.
+	 * @param path The file to write
+	 * @param layers The synthesizers of the layers, softest first
+	 * @param layerVel The highest velocity (0 - 1) of each layer
+	 * @param nLayers The number of layers, at most NOTEBANK_MAX_LAYERS
+	 * @param firstNote The MIDI number of the lowest note
+	 * @param nNotes The number of notes
+	 * @param nFrames The length of every note in samples
+	 * @return false IFF the arguments are invalid or the file could not be written
+	 */
+	static bool bake(const char *path, ModalURB **layers, const float *layerVel, int nLayers,
+		int firstNote, int nNotes, int nFrames);
+
+	/**
+	 * open maps a bank file. The pages are not read.
+	 * @param path The file
+	 * @return false IFF the file could not be mapped or is not a valid bank
+	 */
+	bool open(const char *path);
+
+	/**
+	 * close unmaps the file. The pointers given by getNote become invalid.
+	 */
+	void close();
+
+	bool isOpen(){return header != 0;}
+	double getFs(){return header ? header->Fs : 0;}
+	int getFirstNote(){return header ? header->firstNote : 0;}
+	int getNumNotes(){return header ? header->nNotes : 0;}
+	int getNumLayers(){return header ? header->nLayers : 0;}
+	int getLength(){return header ? header->length : 0;}
+
+	/**
+	 * getLayer finds the layer of a velocity
+	 * @param velocity The velocity, 0 - 1
+	 * @return The softest layer whose highest velocity is not below velocity
+	 */
+	int getLayer(double velocity);
+
+	/**
+	 * getNote points at the samples of a note in the mapping
+	 * @param note The MIDI number of the note
+	 * @param layer The velocity layer
+	 * @return The getLength() samples of the note, or 0 if it is not in the bank
+	 */
+	const float *getNote(int note, int layer);
+
+	/**
+	 * prefetch asks the system to read the pages of a note ahead,
+	 * e.g. on note on, so that the first blocks do not fault.
+	 * @param note The MIDI number of the note
+	 * @param layer The velocity layer
+	 */
+	void prefetch(int note, int layer);
+
+	/**
+	 * readNote adds a block of a note, scaled by a gain, to a
+	 * buffer. The block is cut at the end of the note.
+	 * @param note The MIDI number of the note
+	 * @param layer The velocity layer
+	 * @param pos The first sample of the note to read
+	 * @param gain The gain applied to the samples
+	 * @param output The buffer the samples are added to
+	 * @param nFrames The number of samples
+	 * @return The number of samples added, 0 once the note is over
+	 */
+	int readNote(int note, int layer, int pos, double gain, double *output, int nFrames);
+};
+#endif
@@ -0,0 +1,324 @@
+#include "NoteCache.h"
+#include <cstring>
+
+CachedNote NoteCache::tombstone;
+
+/**
+ * Creates an empty cache
+ * @param budgetBytes The largest total size of the samples
+ * @param n The largest number of notes
+ */
+NoteCache::NoteCache(size_t budgetBytes, int n) : readers(0), tick(0), hits(0), misses(0){
+	maxNotes = n > 0 ? n : 1;
+	//at most half full, so that a miss stops on an empty slot early
+	capacity = 1;
+	while(capacity < 2 * maxNotes) capacity <<= 1;
+	slots = new std::atomic<CachedNote*>[capacity];
+	for(int i = 0; i < capacity; i++) slots[i].store(0);
+	nNotes = 0;
+	nTombstones = 0;
+	budget = budgetBytes;
+	bytes = 0;
+	retired = 0;
+}
+
+/**
+ * Frees every note. No note may be pinned.
+ */
+NoteCache::~NoteCache(){
+	for(int i = 0; i < capacity; i++){
+		CachedNote *n = slots[i].load();
+		if(n && n != &tombstone){
+			delete[] n->samples;
+			delete n;
+		}
+	}
+	while(retired){
+		CachedNote *n = retired;
+		retired = n->nextRetired;
+		delete[] n->samples;
+		delete n;
+	}
+	delete[] slots;
+}
+
+size_t NoteCache::hashKey(const NoteKey &k){
+	unsigned long long words[4];
+	memcpy(words, &k.f0, sizeof(double));
+	memcpy(words + 1, &k.Fs, sizeof(double));
+	words[2] = (unsigned long long)k.length;
+	words[3] = k.modeHash;
+	//FNV-1a over the bytes of the key
+	unsigned long long h = 14695981039346656037ULL;
+	const unsigned char *p = (const unsigned char*)words;
+	for(size_t i = 0; i < sizeof(words); i++){
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return (size_t)(h ^ (h >> 32));
+}
+
+/**
+ * makeKey builds the key of a note of a synthesizer
+ * @param synth The synthesizer, for its sample rate and mode table
+ * @param f The fundamental of the note
+ * @param nFrames The length of the note in samples
+ * @return The key
+ */
+NoteKey NoteCache::makeKey(ModalURB &synth, double f, int nFrames){
+	NoteKey k;
+	k.f0 = f;
+	k.Fs = synth.getFs();
+	k.length = nFrames;
+	k.modeHash = synth.getModeHash();
+	return k;
+}
+
+/**
+ * find probes the table for a key, without pinning
+ * @param k The key
+ * @return The note, or 0
+ */
+CachedNote *NoteCache::find(const NoteKey &k){
+	size_t mask = capacity - 1;
+	size_t i = hashKey(k) & mask;
+	for(int p = 0; p < capacity; p++){
+		CachedNote *n = slots[i].load();
+		if(!n) return 0;
+		if(n != &tombstone && n->key == k) return n;
+		i = (i + 1) & mask;
+	}
+	return 0;
+}
+
+/**
+ * acquire searches the cache and pins the note found. A note
+ * unlinked by a writer after it was loaded here stays allocated,
+ * because the writers do not free anything while a reader is
+ * inside this function.
+ * @param k The key of the note
+ * @return The pinned note, to give back to release, or 0 on a miss
+ */
+const CachedNote *NoteCache::acquire(const NoteKey &k){
+	readers.fetch_add(1);
+	CachedNote *n = find(k);
+	if(n) n->refs.fetch_add(1);
+	readers.fetch_sub(1);
+
+	if(!n){
+		misses.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
+	hits.fetch_add(1, std::memory_order_relaxed);
+	n->lastUse.store(tick.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return n;
+}
+
+/**
+ * release unpins a note returned by acquire or insert. It never
+ * frees memory, so it is safe on the audio thread.
+ * @param n The note, may be 0
+ */
+void NoteCache::release(const CachedNote *n){
+	if(n) const_cast<CachedNote*>(n)->refs.fetch_sub(1);
+}
+
+/**
+ * link stores a note in the first free slot of its probe
+ * sequence. Called with the lock held.
+ * @param n The note
+ */
+void NoteCache::link(CachedNote *n){
+	size_t mask = capacity - 1;
+	size_t i = hashKey(n->key) & mask;
+	for(int p = 0; p < capacity; p++){
+		CachedNote *s = slots[i].load();
+		if(!s || s == &tombstone){
+			if(s) nTombstones--;
+			slots[i].store(n);
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+}
+
+/**
+ * rebuild empties the table of its tombstones. Readers racing
+ * with it may miss a note, which only costs a render.
+ * Called with the lock held.
+ */
+void NoteCache::rebuild(){
+	CachedNote **live = new CachedNote*[nNotes > 0 ? nNotes : 1];
+	int count = 0;
+	for(int i = 0; i < capacity; i++){
+		CachedNote *n = slots[i].load();
+		if(n && n != &tombstone) live[count++] = n;
+		slots[i].store(0);
+	}
+	nTombstones = 0;
+	for(int i = 0; i < count; i++) link(live[i]);
+	delete[] live;
+}
+
+/**
+ * evictOne unlinks the least recently used note and retires it.
+ * Called with the lock held.
+ * @return false IFF the cache is empty
+ */
+bool NoteCache::evictOne(){
+	int oldest = -1;
+	unsigned long oldestUse = 0;
+	for(int i = 0; i < capacity; i++){
+		CachedNote *n = slots[i].load();
+		if(!n || n == &tombstone) continue;
+		unsigned long use = n->lastUse.load(std::memory_order_relaxed);
+		if(oldest < 0 || use < oldestUse){
+			oldest = i;
+			oldestUse = use;
+		}
+	}
+	if(oldest < 0) return false;
+
+	CachedNote *n = slots[oldest].load();
+	slots[oldest].store(&tombstone);
+	nTombstones++;
+	nNotes--;
+	bytes -= n->length * sizeof(double);
+	n->nextRetired = retired;
+	retired = n;
+	return true;
+}
+
+/**
+ * collect frees the retired notes that nobody can read any
+ * more: they are unlinked, so a reader entering acquire after
+ * the check cannot find them, and a reader that found them
+ * before has pinned them. Called with the lock held.
+ */
+void NoteCache::collect(){
+	if(!retired || readers.load() != 0) return;
+	CachedNote **p = &retired;
+	while(*p){
+		CachedNote *n = *p;
+		if(n->refs.load() == 0){
+			*p = n->nextRetired;
+			delete[] n->samples;
+			delete n;
+		}
+		else p = &n->nextRetired;
+	}
+}
+
+/**
+ * insert adds a note, evicting the least recently used notes
+ * to stay under the budget. The cache takes ownership of the
+ * samples, that must have been allocated with new[].
+ * @param k The key of the note
+ * @param samples The samples, allocated with new[]
+ * @param length The number of samples
+ * @return The pinned note, or 0 if it is larger than the budget
+ * (the samples are deleted)
+ */
+const CachedNote *NoteCache::insert(const NoteKey &k, double *samples, int length){
+	std::lock_guard<std::mutex> guard(lock);
+	collect();
+
+	size_t size = length * sizeof(double);
+	if(length <= 0 || size > budget){
+		delete[] samples;
+		return 0;
+	}
+
+	CachedNote *n = find(k);
+	if(n){
+		delete[] samples;
+		n->refs.fetch_add(1);
+		return n;
+	}
+
+	while(bytes + size > budget || nNotes >= maxNotes){
+		if(!evictOne()) break;
+	}
+	if(nTombstones > capacity / 4) rebuild();
+
+	n = new CachedNote;
+	n->key = k;
+	n->samples = samples;
+	n->length = length;
+	n->refs.store(1);
+	n->lastUse.store(tick.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	n->nextRetired = 0;
+	link(n);
+	nNotes++;
+	bytes += size;
+	return n;
+}
+
+/**
+ * render copies a note to a buffer, rendering it with the
+ * synthesizer and caching it on a miss. A hit is one memcpy.
+ * @param synth The synthesizer
+ * @param f The fundamental of the note
+ * @param output The output buffer
+ * @param nFrames The length of the note in samples
+ * @return true IFF the note was cached before the call
+ */
+bool NoteCache::render(ModalURB &synth, double f, double *output, int nFrames){
+	NoteKey k = makeKey(synth, f, nFrames);
+	const CachedNote *n = acquire(k);
+	if(n){
+		memcpy(output, n->samples, nFrames * sizeof(double));
+		release(n);
+		return true;
+	}
+
+	double *samples = new double[nFrames];
+	synth.generateNote(f, samples, nFrames);
+	memcpy(output, samples, nFrames * sizeof(double));
+	release(insert(k, samples, nFrames));
+	return false;
+}
+
+/**
+ * clear removes every note and resets the counters. The pinned
+ * notes stay readable, they are freed by the first writer after
+ * they are released.
+ */
+void NoteCache::clear(){
+	std::lock_guard<std::mutex> guard(lock);
+	for(int i = 0; i < capacity; i++){
+		CachedNote *n = slots[i].load();
+		slots[i].store(0);
+		if(n && n != &tombstone){
+			n->nextRetired = retired;
+			retired = n;
+		}
+	}
+	nNotes = 0;
+	nTombstones = 0;
+	bytes = 0;
+	hits = 0;
+	misses = 0;
+	collect();
+}
+
+/**
+ * getHitRate
+ * @return hits / (hits + misses), 0 before the first lookup
+ */
+double NoteCache::getHitRate(){
+	unsigned long h = hits.load();
+	unsigned long m = misses.load();
+	if(h + m == 0) return 0;
+	return (double)h / (h + m);
+}
+
+size_t NoteCache::getBytes(){
+	std::lock_guard<std::mutex> guard(lock);
+	return bytes;
+}
+
+int NoteCache::getSize(){
+	std::lock_guard<std::mutex> guard(lock);
+	return nNotes;
+}
@@ -0,0 +1,199 @@
+#ifndef NOTECACHE_H
+#define NOTECACHE_H
+
+//include
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include "ModalURB.h"
+
+/**
+ * Parameters that fully determine a note rendered by
+ * ModalURB::generateNote
+ * @see NoteCache
+ */
+struct NoteKey{
+	double f0;
+	double Fs;
+	int length;						//in samples, the envelope spans the whole note
+	unsigned long long modeHash;	//@see ModalURB::getModeHash
+
+	bool operator==(const NoteKey &k) const{
+		return f0 == k.f0 && Fs == k.Fs && length == k.length && modeHash == k.modeHash;
+	}
+};
+
+/**
+ * A rendered note owned by a NoteCache. Pinned notes are never
+ * freed, so their samples can be played in place.
+ * @see NoteCache::acquire
+ */
+struct CachedNote{
+	NoteKey key;
+	double *samples;
+	int length;
+	std::atomic<int> refs;				//number of pins
+	std::atomic<unsigned long> lastUse;	//tick of the last acquire
+	CachedNote *nextRetired;			//list of evicted notes waiting for their pins
+
+	const double *getSamples() const{return samples;}
+	int getLength() const{return length;}
+};
+
+/**
+ * NoteCache is a bounded LRU cache of notes rendered by
+ * ModalURB. Its notes are keyed on the fundamental, the sample
+ * rate, the length and the mode table, and their total size is
+ * kept under a memory budget by evicting the least recently used.
+ *
+ * The read path is lock-free: acquire probes an open addressed
+ * table of atomic pointers and pins the note it finds, so the
+ * audio thread can start a cached note with a memcpy (render) or
+ * play it in place (acquire / release) without waiting for a
+ * writer. Writers (insert, render on a miss, clear) take a mutex.
+ * An evicted note is unlinked from the table at once but only
+ * freed once no reader is inside acquire and it has no pins.
+ * @see ModalURB
+ */
+class NoteCache{
+protected:
+	int capacity;					//table size, a power of 2
+	std::atomic<CachedNote*> *slots;
+	int maxNotes;
+	int nNotes;
+	int nTombstones;
+	size_t budget;					//in bytes
+	size_t bytes;
+	CachedNote *retired;
+
+	std::mutex lock;				//serializes the writers
+	std::atomic<int> readers;		//threads inside acquire
+	std::atomic<unsigned long> tick;
+	std::atomic<unsigned long> hits;
+	std::atomic<unsigned long> misses;
+
+	static CachedNote tombstone;	//marks a removed slot, so probing goes on
+
+	static size_t hashKey(const NoteKey &k);
+
+	/**
+	 * find probes the table for a key, without pinning
+	 * @param k The key
+	 * @return The note, or 0
+	 */
+	CachedNote *find(const NoteKey &k);
+
+	/**
+	 * link stores a note in the first free slot of its probe
+	 * sequence. Called with the lock held.
+	 * @param n The note
+	 */
+	void link(CachedNote *n);
+
+	/**
+	 * rebuild empties the table of its tombstones. Readers racing
+	 * with it may miss a note, which only costs a render.
+	 * Called with the lock held.
+	 */
+	void rebuild();
+
+	/**
+	 * evictOne unlinks the least recently used note and retires it.
+	 * Called with the lock held.
+	 * @return false IFF the cache is empty
+	 */
+	bool evictOne();
+
+	/**
+	 * collect frees the retired notes that nobody can read any
+	 * more. Called with the lock held.
+	 */
+	void collect();
+
+public:
+	/**
+	 * Creates an empty cache
+	 * @param budgetBytes The largest total size of the samples
+	 * @param n The largest number of notes
+	 */
+	NoteCache(size_t budgetBytes, int n = 1024);
+
+	/**
+	 * Frees every note. No note may be pinned.
+	 */
+	~NoteCache();
+
+	//not copyable, a copy would free the notes twice
+	NoteCache(const NoteCache &) = delete;
+	NoteCache &operator=(const NoteCache &) = delete;
+
+	/**
+	 * makeKey builds the key of a note of a synthesizer
+	 * @param synth The synthesizer, for its sample rate and mode table
+	 * @param f The fundamental of the note
+	 * @param nFrames The length of the note in samples
+	 * @return The key
+	 */
+	static NoteKey makeKey(ModalURB &synth, double f, int nFrames);
+
+	/**
+	 * acquire searches the cache and pins the note found. Lock-free
+	 * and allocation free, safe on the audio thread. Counts a hit or
+	 * a miss.
+	 * @param k The key of the note
+	 * @return The pinned note, to give back to release, or 0 on a miss
+	 */
+	const CachedNote *acquire(const NoteKey &k);
+
+	/**
+	 * release unpins a note returned by acquire or insert
+	 * @param n The note, may be 0
+	 */
+	void release(const CachedNote *n);
+
+	/**
+	 * insert adds a note, evicting the least recently used notes
+	 * to stay under the budget. The cache takes ownership of the
+	 * samples, that must have been allocated with new[].
+	 * If the key is already cached the samples are deleted and the
+	 * cached note is returned.
+	 * @param k The key of the note
+	 * @param samples The samples, allocated with new[]
+	 * @param length The number of samples
+	 * @return The pinned note, or 0 if it is larger than the budget
+	 * (the samples are deleted)
+	 */
+	const CachedNote *insert(const NoteKey &k, double *samples, int length);
+
+	/**
+	 * render copies a note to a buffer, rendering it with the
+	 * synthesizer and caching it on a miss. A hit is one memcpy.
+	 * @param synth The synthesizer
+	 * @param f The fundamental of the note
+	 * @param output The output buffer
+	 * @param nFrames The length of the note in samples
+	 * @return true IFF the note was cached before the call
+	 */
+	bool render(ModalURB &synth, double f, double *output, int nFrames);
+
+	/**
+	 * clear removes every note and resets the counters. The pinned
+	 * notes stay readable, they are freed by the first writer after
+	 * they are released.
+	 */
+	void clear();
+
+	unsigned long getHits(){return hits.load();}
+	unsigned long getMisses(){return misses.load();}
+
+	/**
+	 * getHitRate
+	 * @return hits / (hits + misses), 0 before the first lookup
+	 */
+	double getHitRate();
+
+	size_t getBytes();
+	size_t getBudget(){return budget;}
+	int getSize();
+};
+#endif
@@ -0,0 +1,68 @@
+#ifndef PARAMETEREVENT_H
+#define PARAMETEREVENT_H
+
+/**
+ * ParameterEvent is a parameter change scheduled at a sample
+ * offset within the next buffer, as handed over by the host. The
+ * event list overloads of processBuffer split the buffer at the
+ * offsets, so the change takes effect exactly at that sample.
+ * Event lists must be sorted by offset. Offsets below 0 apply at
+ * the start of the buffer, offsets past the end after it.
+ * The meaning of param is defined by each processor.
+ * @see Biquad
+ * @see LinkwitzRiley
+ * @see Dynamics
+ */
+struct ParameterEvent{
+	int offset;					//sample offset in the buffer
+	unsigned int param;			//parameter id of the processor
+	double value;				//new value of the parameter
+};
+
+/**
+ * nextEventOffset gives the end of the sub-block starting at pos,
+ * that is the offset of the next event or nFrames.
+ * @param events The sorted event list
+ * @param e The index of the next event to apply
+ * @param nEvents The number of events in the list
+ * @param nFrames The number of samples in the buffer
+ * @return The sample at which the sub-block ends
+ */
+inline int nextEventOffset(const ParameterEvent *events, int e, int nEvents, int nFrames){
+	if(e < nEvents && events[e].offset < nFrames) return events[e].offset;
+	return nFrames;
+}
+
+/**
+ * splitAtEvents runs a processor over a buffer in sub-blocks that
+ * end at the event offsets. Before each sub-block the events due
+ * are given to apply, then commit is called once if any of them
+ * changed a parameter, so that the events sharing an offset cost
+ * a single update. The events past the end of the buffer are
+ * applied after the last sub-block.
+ * @param events The sorted event list
+ * @param nEvents The number of events in the list
+ * @param nFrames The number of samples in the buffer
+ * @param apply bool(const ParameterEvent&) storing an event, true IFF it changed a parameter
+ * @param commit void() updating the processor after its parameters changed
+ * @param process void(int pos, int n) processing the n samples starting at pos
+ */
+template<typename Apply, typename Commit, typename Process>
+inline void splitAtEvents(const ParameterEvent *events, int nEvents, int nFrames, Apply apply, Commit commit, Process process){
+	int e = 0;
+	int pos = 0;
+	while(true){
+		bool changed = false;
+		while(e < nEvents && (events[e].offset <= pos || pos >= nFrames)){
+			if(apply(events[e])) changed = true;
+			e++;
+		}
+		if(changed) commit();
+		if(pos >= nFrames) break;
+
+		int end = nextEventOffset(events, e, nEvents, nFrames);
+		process(pos, end - pos);
+		pos = end;
+	}
+}
+#endif
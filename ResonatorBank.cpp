@@ -0,0 +1,218 @@
+#include "ResonatorBank.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//vector type of BANK_WIDTH doubles and the few operations the kernel needs
+#if defined(__AVX__)
+typedef __m256d rvec;
+static inline rvec rLoad(const double *p){return _mm256_loadu_pd(p);}
+static inline void rStore(double *p, rvec v){_mm256_storeu_pd(p, v);}
+static inline rvec rZero(){return _mm256_setzero_pd();}
+static inline rvec rAdd(rvec a, rvec b){return _mm256_add_pd(a, b);}
+static inline rvec rMul(rvec a, rvec b){return _mm256_mul_pd(a, b);}
+static inline double rSum(rvec v){
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+typedef __m128d rvec;
+static inline rvec rLoad(const double *p){return _mm_loadu_pd(p);}
+static inline void rStore(double *p, rvec v){_mm_storeu_pd(p, v);}
+static inline rvec rZero(){return _mm_setzero_pd();}
+static inline rvec rAdd(rvec a, rvec b){return _mm_add_pd(a, b);}
+static inline rvec rMul(rvec a, rvec b){return _mm_mul_pd(a, b);}
+static inline double rSum(rvec v){return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));}
+#else
+typedef double rvec;
+static inline rvec rLoad(const double *p){return *p;}
+static inline void rStore(double *p, rvec v){*p = v;}
+static inline rvec rZero(){return 0;}
+static inline rvec rAdd(rvec a, rvec b){return a + b;}
+static inline rvec rMul(rvec a, rvec b){return a * b;}
+static inline double rSum(rvec v){return v;}
+#endif
+
+/**
+ * Creates a bank of n silent resonators.
+ * @param n The number of resonators
+ */
+ResonatorBank::ResonatorBank(int n){
+	//round up so that the kernel never reads past the arrays
+	nLanes = (n + BANK_WIDTH - 1) / BANK_WIDTH * BANK_WIDTH;
+
+	//one block for all the SoA arrays
+	m11 = new double[9 * nLanes];
+	m12 = m11 + nLanes;
+	m21 = m12 + nLanes;
+	m22 = m21 + nLanes;
+	u = m22 + nLanes;
+	v = u + nLanes;
+	seedU = v + nLanes;
+	seedV = seedU + nLanes;
+	direct = seedV + nLanes;
+
+	for(int l = 0; l < 9 * nLanes; l++) m11[l] = 0;
+}
+
+ResonatorBank::~ResonatorBank(){
+	delete[] m11;
+}
+
+/**
+ * tune designs a resonator as a band pass filter, converts it
+ * to its oscillator form and clears its state. The impulse
+ * response h of the biquad is b2/a2 at n = 0 plus a sequence g
+ * that follows the feedback recursion for every n; the state is
+ * seeded with g[0] and g[1] = h[1]. Since the resonator is
+ * linear, its weight scales the seeds instead of every output.
+ * A resonator given invalid parameters is silenced.
+ * @param l The resonator
+ * @param fs The sample rate
+ * @param f The center frequency, below fs / 2
+ * @param bw The bandwidth in octaves
+ * @param gain The weight of the resonator in the sum
+ * @return false IFF fs, f or bw is not positive or f is not below fs / 2
+ */
+bool ResonatorBank::tune(int l, double fs, double f, double bw, double gain){
+	StaticBiquad<BandPass, OctaveBW> design;
+	if(!(f < fs / 2) || !design.setParams(fs, f, bw)){
+		m11[l] = m12[l] = m21[l] = m22[l] = 0;
+		seedU[l] = seedV[l] = direct[l] = 0;
+		clear(l, 1);
+		return false;
+	}
+	double as[3];
+	double bs[3];
+	design.getNormCoFs(as, bs);
+	double a1 = as[1], a2 = as[2];
+
+	double d = bs[2] / a2;
+	double g0 = bs[0] - d;
+	double g1 = bs[1] - a1 * bs[0];
+
+	double r = sqrt(a2);
+	double c = -a1 / (2 * r);
+	if(c > -1 && c < 1){
+		//complex poles r e^(+-j theta): coupled form
+		double s = sqrt(1 - c * c);
+		m11[l] = r * c;
+		m12[l] = -r * s;
+		m21[l] = r * s;
+		m22[l] = r * c;
+		seedU[l] = gain * g0;
+		seedV[l] = gain * (c * g0 - g1 / r) / s;
+	}
+	else{
+		//real poles: companion form, v holds g[n-1]
+		m11[l] = -a1;
+		m12[l] = -a2;
+		m21[l] = 1;
+		m22[l] = 0;
+		seedU[l] = gain * g0;
+		seedV[l] = -gain * (g1 + a1 * g0) / a2;
+	}
+	direct[l] = gain * d;
+	clear(l, 1);
+	return true;
+}
+
+/**
+ * clear silences a range of resonators
+ * @param first The first resonator
+ * @param count The number of resonators
+ */
+void ResonatorBank::clear(int first, int count){
+	for(int l = first; l < first + count; l++){
+		u[l] = 0;
+		v[l] = 0;
+	}
+}
+
+/**
+ * copy copies the design and the state of a range of
+ * resonators to another, non overlapping range
+ * @param from The first resonator to copy
+ * @param to The first resonator to overwrite
+ * @param count The number of resonators
+ */
+void ResonatorBank::copy(int from, int to, int count){
+	//the nine arrays are consecutive blocks of nLanes
+	for(int a = 0; a < 9; a++){
+		double *base = m11 + a * nLanes;
+		for(int l = 0; l < count; l++) base[to + l] = base[from + l];
+	}
+}
+
+/**
+ * flush sets the denormal state of a range of resonators to 0
+ * @param first The first resonator
+ * @param count The number of resonators
+ */
+void ResonatorBank::flush(int first, int count){
+	for(int l = first; l < first + count; l++){
+		Denormals::flush(u[l]);
+		Denormals::flush(v[l]);
+	}
+}
+
+/**
+ * processGroups renders G vectors of BANK_WIDTH resonators. The
+ * vectors are independent, so interleaving two of them hides the
+ * latency of the recursion.
+ * @see process()
+ */
+template<int G>
+void ResonatorBank::processGroups(int first, double env, double envStep, double *output, int nFrames){
+	rvec v11[G], v12[G], v21[G], v22[G], vu[G], vv[G];
+	for(int g = 0; g < G; g++){
+		int l = first + g * BANK_WIDTH;
+		v11[g] = rLoad(m11 + l);
+		v12[g] = rLoad(m12 + l);
+		v21[g] = rLoad(m21 + l);
+		v22[g] = rLoad(m22 + l);
+		vu[g] = rLoad(u + l);
+		vv[g] = rLoad(v + l);
+	}
+
+	for(int i = 0; i < nFrames; i++){
+		rvec acc = rZero();
+		for(int g = 0; g < G; g++){
+			rvec y = vu[g];
+			vu[g] = rAdd(rMul(v11[g], y), rMul(v12[g], vv[g]));
+			vv[g] = rAdd(rMul(v21[g], y), rMul(v22[g], vv[g]));
+			acc = rAdd(acc, y);
+		}
+		output[i] += env * rSum(acc);
+		env -= envStep;
+	}
+
+	for(int g = 0; g < G; g++){
+		int l = first + g * BANK_WIDTH;
+		rStore(u + l, vu[g]);
+		rStore(v + l, vv[g]);
+	}
+}
+
+/**
+ * process adds the weighted sum of a range of resonators,
+ * scaled by a linear envelope, to a buffer.
+ * @param first The first resonator, a multiple of BANK_WIDTH
+ * @param count The number of resonators
+ * @param env The envelope gain on the first sample
+ * @param envStep The decrease of the envelope per sample
+ * @param output The buffer the sum is added to
+ * @param nFrames The number of samples
+ */
+void ResonatorBank::process(int first, int count, double env, double envStep, double *output, int nFrames){
+	if(nFrames <= 0) return;
+	int end = first + count;
+	int l = first;
+	for(; l + BANK_WIDTH < end; l += 2 * BANK_WIDTH){
+		processGroups<2>(l, env, envStep, output, nFrames);
+	}
+	if(l < end) processGroups<1>(l, env, envStep, output, nFrames);
+}
@@ -0,0 +1,133 @@
+#ifndef RESONATORBANK_H
+#define RESONATORBANK_H
+
+//include
+#include "StaticBiquad.h"
+#include "BiquadBank.h"				//BANK_WIDTH
+
+/**
+ * ResonatorBank holds many band pass resonators in
+ * structure-of-arrays layout and renders the weighted sum of a
+ * range of them, BANK_WIDTH resonators per SSE/AVX instruction
+ * and two vectors at a time. The sum is done inside the kernel,
+ * so there is one output buffer and no copy per resonator.
+ * Each resonator is a free running damped oscillator: its
+ * impulse response is, after the first sample, a sum of
+ * geometric sequences that a 2x2 recursion reproduces without
+ * input. When the poles are complex the recursion is the coupled
+ * form (a rotation by theta scaled by r, with r = sqrt(a2) and
+ * cos(theta) = -a1 / (2r)), which keeps its precision at low
+ * frequencies; when they are real it is the companion form.
+ * Exciting a resonator seeds its state with the impulse response,
+ * so no input buffer is filtered at all.
+ * @see ModalURB
+ */
+class ResonatorBank{
+protected:
+	int nLanes;					//number of resonators
+
+	//recursion u' = m11 u + m12 v, v' = m21 u + m22 v, output u
+	double *m11;
+	double *m12;
+	double *m21;
+	double *m22;
+
+	//state, and the state seeded by a unit impulse. The weight of
+	//the resonator in the sum is folded into the seeds.
+	double *u;
+	double *v;
+	double *seedU;
+	double *seedV;
+	double *direct;				//weighted part of the first output not given by u
+
+	/**
+	 * processGroups renders G vectors of BANK_WIDTH resonators
+	 * into the vector sums of each sample.
+	 * @see process()
+	 */
+	template<int G>
+	void processGroups(int first, double env, double envStep, double *output, int nFrames);
+
+public:
+	/**
+	 * Creates a bank of n silent resonators.
+	 * @param n The number of resonators
+	 */
+	ResonatorBank(int n);
+
+	~ResonatorBank();
+
+	//not copyable, a copy would free the lanes twice
+	ResonatorBank(const ResonatorBank &) = delete;
+	ResonatorBank &operator=(const ResonatorBank &) = delete;
+
+	int getNumLanes(){return nLanes;}
+
+	/**
+	 * tune designs a resonator as a band pass filter, converts it
+	 * to its oscillator form and clears its state. A resonator
+	 * given invalid parameters is silenced.
+	 * @param l The resonator
+	 * @param fs The sample rate
+	 * @param f The center frequency, below fs / 2
+	 * @param bw The bandwidth in octaves
+	 * @param gain The weight of the resonator in the sum
+	 * @return false IFF fs, f or bw is not positive or f is not below fs / 2
+	 */
+	bool tune(int l, double fs, double f, double bw, double gain);
+
+	/**
+	 * excite adds the impulse response of a resonator to its
+	 * state, starting on the first sample of the next process
+	 * call. The first sample of a band pass impulse response is
+	 * not part of the oscillation: it is returned, weighted, for
+	 * the caller to add to that sample.
+	 * @param l The resonator
+	 * @param x The amplitude of the impulse
+	 * @return The weighted part of the first output sample to add
+	 */
+	double excite(int l, double x){
+		u[l] += x * seedU[l];
+		v[l] += x * seedV[l];
+		return x * direct[l];
+	}
+
+	/**
+	 * clear silences a range of resonators
+	 * @param first The first resonator
+	 * @param count The number of resonators
+	 */
+	void clear(int first, int count);
+
+	/**
+	 * copy copies the design and the state of a range of
+	 * resonators to another, non overlapping range
+	 * @param from The first resonator to copy
+	 * @param to The first resonator to overwrite
+	 * @param count The number of resonators
+	 */
+	void copy(int from, int to, int count);
+
+	/**
+	 * flush sets the denormal state of a range of resonators to 0
+	 * @param first The first resonator
+	 * @param count The number of resonators
+	 */
+	void flush(int first, int count);
+
+	/**
+	 * process adds the weighted sum of a range of resonators,
+	 * scaled by a linear envelope, to a buffer. first must be a
+	 * multiple of BANK_WIDTH; the resonators after the range up to
+	 * the next multiple of BANK_WIDTH are rendered too, so they
+	 * must be silent or part of the same sum.
+	 * @param first The first resonator
+	 * @param count The number of resonators
+	 * @param env The envelope gain on the first sample
+	 * @param envStep The decrease of the envelope per sample
+	 * @param output The buffer the sum is added to
+	 * @param nFrames The number of samples
+	 */
+	void process(int first, int count, double env, double envStep, double *output, int nFrames);
+};
+#endif
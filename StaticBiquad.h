@@ -0,0 +1,296 @@
+#ifndef STATICBIQUAD_H
+#define STATICBIQUAD_H
+
+//include
+#include "Biquad.h"
+#include "FastMath.h"
+
+/**
+ * Filter modes, same values as the mode parameter of Biquad.
+ */
+enum BiquadMode{
+	BandPass = 0,
+	LowPass = 1,
+	HighPass = 2,
+	Notch = 3,
+	AllPass = 4,
+	LowShelf = 5,
+	HighShelf = 6
+};
+
+/**
+ * Bandwidth modes, same values as the BWMode parameter of Biquad.
+ */
+enum BiquadBWMode{
+	QBW = 0,
+	OctaveBW = 1,
+	SlopeBW = 2
+};
+
+/**
+ * isShelf tells if a mode uses gain and alphaPrime.
+ * @return true IFF M is LowShelf or HighShelf
+ */
+template<unsigned int M>
+inline bool isShelf(){return M == LowShelf || M == HighShelf;}
+
+/**
+ * biquadAlpha computes the intermediary bandwidth parameter alpha
+ * for the bandwidth mode BWM. The tests on BWM are on a template
+ * parameter, so only one formula is left after compilation.
+ * Modes other than OctaveBW and SlopeBW use Q.
+ * @param sinW0 sin(omega0)
+ * @param omega0 The angular frequency
+ * @param bw Q, the bandwidth in octaves or the slope, following BWM
+ * @param gain The linear shelf gain (only used for SlopeBW)
+ * @param fast true to use FastMath for sinh
+ * @return alpha
+ */
+template<unsigned int BWM>
+inline double biquadAlpha(double sinW0, double omega0, double bw, double gain, bool fast){
+	if(BWM == OctaveBW){
+		double x = (LN2) / 2 * bw * omega0/sinW0;
+		return sinW0 * (fast ? fastSinh(x) : sinh(x));
+	}
+	if(BWM == SlopeBW) return sinW0/2 * sqrt( (gain+1/gain)*(1/bw-1)+2 );
+	return sinW0 / (2 * bw);
+}
+
+/**
+ * biquadCoFs computes the raw (not normalized) coefficients of the
+ * mode M from the intermediary parameters. The tests on M are on
+ * a template parameter, so only the branch of the mode is left
+ * after compilation. Modes above HighShelf are band pass filters.
+ * @param cosW0 cos(omega0)
+ * @param alpha The intermediary BW parameter
+ * @param alphaPrime 2 * sqrt(gain) * alpha, only for shelves
+ * @param gain The linear shelf gain, only for shelves
+ * @param bs A size 3 array receiving b0, b1 and b2
+ * @param as A size 3 array receiving a0, a1 and a2
+ */
+template<unsigned int M>
+inline void biquadCoFs(double cosW0, double alpha, double alphaPrime, double gain, double *bs, double *as){
+	if(isShelf<M>()){
+		//calculate some intermediate vars
+		double gp = gain+1;
+		double gm = gain-1;
+		double mc = gm*cosW0;
+		double pc = gp*cosW0;
+		double pmm = gp - mc;
+		double mmp = gm - pc;
+		double ppm = gp + mc;
+		double mpp = gm + pc;
+		if(M == LowShelf){
+			bs[0] = gain * (pmm + alphaPrime);
+			bs[1] = 2 * gain * mmp;
+			bs[2] = gain * (pmm - alphaPrime);
+			as[0] = ppm + alphaPrime;
+			as[1] = -2 * mpp;
+			as[2] = ppm - alphaPrime;
+		}
+		else{
+			bs[0] = gain * (ppm + alphaPrime);
+			bs[1] = -2 * gain * mpp;
+			bs[2] = gain * (ppm -  alphaPrime);
+			as[0] = pmm + alphaPrime;
+			as[1] = 2 * mmp;
+			as[2] = pmm - alphaPrime;
+		}
+		return;
+	}
+
+	as[0] = 1 + alpha;
+	as[1] = -2 * cosW0;
+	as[2] = 1 - alpha;
+	if(M == LowPass){
+		bs[1] = 1 - cosW0;
+		bs[0] = bs[1]/2;
+		bs[2] = bs[0];
+	}
+	else if(M == HighPass){
+		bs[0] = (1 + cosW0)/2;
+		bs[1] = -(1 + cosW0);
+		bs[2] = bs[0];
+	}
+	else if(M == Notch){
+		bs[0] = 1;
+		bs[1] = as[1];
+		bs[2] = 1;
+	}
+	else if(M == AllPass){
+		bs[0] = as[2];
+		bs[1] = as[1];
+		bs[2] = as[0];
+	}
+	else{
+		bs[0] = alpha;
+		bs[1] = 0;
+		bs[2] = -1 * alpha;
+	}
+}
+
+/**
+ * StaticBiquad is a biquad filter whose mode and bandwidth mode
+ * are fixed at compile time, e.g. StaticBiquad<LowShelf, SlopeBW>.
+ * The design has no switch on the mode and only computes the
+ * intermediary values the mode needs (no pow for non shelving
+ * filters, and for shelves only when the gain changes), which
+ * makes it suited to per block redesigns of many filters. The
+ * results are identical to a Biquad of the same mode. Processing
+ * uses the same BiquadKernel as Biquad.
+ * @see Biquad
+ */
+template<unsigned int M, unsigned int BWM>
+class StaticBiquad{
+protected:
+	BiquadKernel hot;				//normalized coFs and state
+	double Fs;						//sample frequency
+	double fc;						//center/cutoff frequency
+	double bw;						//Q, BW or slope following BWM
+	double dBG;						//gain in dB, only for shelves
+	double gain;					//linear gain of dBG, so that setFc needs no pow
+	bool fastMath;					//true to design with FastMath
+
+	/**
+	 * updateGain computes the linear gain from dBG. Only shelves
+	 * use it, the other modes keep 1.
+	 */
+	void updateGain(){
+		gain = 1;
+		if(isShelf<M>()) gain = fastMath ? fastPow10(dBG/40) : pow(10, dBG/40);
+	}
+
+public:
+	/**
+	 * Creates a filter that passes its input through unchanged
+	 * until its parameters are set.
+	 */
+	StaticBiquad(){
+		Fs = 0;
+		fc = 0;
+		bw = 0;
+		dBG = 0;
+		gain = 1;
+		fastMath = false;
+		hot.b0 = 1;
+		hot.b1 = hot.b2 = hot.a1 = hot.a2 = 0;
+		initHist();
+	}
+
+	/**
+	 * Creates and designs a filter. If the parameters are invalid
+	 * the filter passes its input through unchanged.
+	 * @param fs The sample frequency
+	 * @param f The center/cutoff frequency
+	 * @param b Q, the bandwidth in octaves or the slope following BWM
+	 * @param dbg The gain in dB. Only used by shelving filters
+	 */
+	StaticBiquad(double fs, double f, double b, double dbg = 0) : StaticBiquad(){
+		setParams(fs, f, b, dbg);
+	}
+
+	/**
+	 * setParams sets all the parameters and designs the filter.
+	 * @param fs The sample frequency
+	 * @param f The center/cutoff frequency
+	 * @param b Q, the bandwidth in octaves or the slope following BWM
+	 * @param dbg The gain in dB. Only used by shelving filters
+	 * @return true IFF the parameters are valid
+	 */
+	bool setParams(double fs, double f, double b, double dbg = 0){
+		if(!(fs > 0) || !(f > 0) || !(b > 0)) return false;
+		Fs = fs;
+		fc = f;
+		bw = b;
+		dBG = dbg;
+		updateGain();
+		design();
+		return true;
+	}
+
+	/**
+	 * setFc changes only the center/cutoff frequency
+	 * @param f The new frequency
+	 * @return true IFF f is valid
+	 */
+	bool setFc(double f){
+		if(!(f > 0)) return false;
+		fc = f;
+		design();
+		return true;
+	}
+
+	/**
+	 * setFastMath selects FastMath approximations for the design.
+	 * The filter is redesigned if its parameters are set.
+	 * @param fast true to use FastMath
+	 */
+	void setFastMath(bool fast){
+		fastMath = fast;
+		updateGain();
+		if(Fs > 0) design();
+	}
+
+	/**
+	 * design computes the normalized coefficients from Fs, fc, bw
+	 * and the gain of dBG. The state is kept.
+	 */
+	void design(){
+		double omega0 = 2 * M_PI * fc / Fs;
+		double cosW0 = fastMath ? fastCos(omega0) : cos(omega0);
+		double sinW0 = fastMath ? fastSin(omega0) : sin(omega0);
+		double alpha = biquadAlpha<BWM>(sinW0, omega0, bw, gain, fastMath);
+		double alphaPrime = 0;
+		if(isShelf<M>()) alphaPrime = 2 * sqrt(gain) * alpha;
+
+		double as[3];
+		double bs[3];
+		biquadCoFs<M>(cosW0, alpha, alphaPrime, gain, bs, as);
+		double inv = 1 / as[0];
+		hot.b0 = bs[0] * inv;
+		hot.b1 = bs[1] * inv;
+		hot.b2 = bs[2] * inv;
+		hot.a1 = as[1] * inv;
+		hot.a2 = as[2] * inv;
+	}
+
+	/**
+	 * initHist clears the state of the filter
+	 */
+	void initHist(){
+		hot.s1 = 0;
+		hot.s2 = 0;
+	}
+
+	/**
+	 * getNormCoFs copies the coefficients normalized by a0.
+	 * @param as A size 3 array receiving 1, a1 and a2
+	 * @param bs A size 3 array receiving b0, b1 and b2
+	 */
+	void getNormCoFs(double *as, double *bs){
+		as[0] = 1;
+		as[1] = hot.a1;
+		as[2] = hot.a2;
+		bs[0] = hot.b0;
+		bs[1] = hot.b1;
+		bs[2] = hot.b2;
+	}
+
+	/**
+	 * processBuffer applies the filter to a sample buffer.
+	 * @param input A T array of size nFrames holding the input signal
+	 * @param output A T buffer of size nFrames. May be the same as input.
+	 * @param nFrames The number of samples in the buffers
+	 * @see processKernel()
+	 */
+	template<typename T>
+	void processBuffer(T *input, T *output, int nFrames){
+		processKernel(hot, input, output, nFrames);
+	}
+
+	double getFs(){return Fs;}
+	double getFc(){return fc;}
+	double getBWParam(){return bw;}
+	double getdBGain(){return dBG;}
+};
+#endif
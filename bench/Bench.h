@@ -0,0 +1,48 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+//include
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+/**
+ * Helpers shared by the benchmarks of bench/. Each benchmark is a
+ * single source built from the root of the repository with the
+ * command line given in its first comment.
+ */
+
+/**
+ * benchNow
+ * @return A monotonic time in seconds
+ */
+inline double benchNow(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * benchNoise fills a buffer with uniform noise in [-1, 1]
+ * @param x The buffer
+ * @param n The number of samples
+ */
+inline void benchNoise(double *x, int n){
+	for(int i = 0; i < n; i++) x[i] = rand() / (double)RAND_MAX * 2 - 1;
+}
+
+/**
+ * benchReport prints the cost of a path in nanoseconds per sample
+ * @param name The name of the path
+ * @param seconds The time taken
+ * @param samples The number of samples processed
+ * @return The cost in nanoseconds per sample
+ */
+inline double benchReport(const char *name, double seconds, double samples){
+	double ns = seconds / samples * 1e9;
+	printf("%-28s %8.2f ns/sample\n", name, ns);
+	return ns;
+}
+
+//keeps a result alive so the optimizer does not remove the work
+static volatile double benchSink;
+
+#endif
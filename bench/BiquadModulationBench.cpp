@@ -0,0 +1,57 @@
+/**
+ * Measures the cost per sample of audio rate cutoff modulation:
+ * the modulated Biquad::processBuffer against a full redesign with
+ * setFc before every sample, driven by the same LFO. The largest
+ * difference between the two outputs is printed as well.
+ *
+ * g++ -O2 -std=c++11 -I. bench/BiquadModulationBench.cpp Biquad.cpp BiquadCache.cpp -pthread -o modulation_bench
+ */
+#include "Biquad.h"
+#include "Bench.h"
+
+#define FRAMES 512
+#define RUNS 1000
+
+int main(){
+	Denormals::setEnabled(true);
+	const int n = FRAMES * RUNS;
+	double *x = new double[n];
+	double *fcMod = new double[n];
+	double *a = new double[n];
+	double *b = new double[n];
+	benchNoise(x, n);
+	//5 Hz LFO between 200 Hz and 8 kHz
+	for(int i = 0; i < n; i++) fcMod[i] = 4100 + 3900 * std::sin(2 * M_PI * 5 * i / 48000);
+
+	const char *names[] = {"band pass", "low pass", "high pass", "notch", "all pass", "low shelf", "high shelf"};
+	for(unsigned int m = 0; m < 7; m++){
+		Biquad perSample(m, 0, 48000, fcMod[0], 0.707, 6);
+		double t = benchNow();
+		for(int i = 0; i < n; i++){
+			perSample.setFc(fcMod[i], true);
+			perSample.processBuffer(x + i, a + i, 1);
+		}
+		double before = (benchNow() - t) / n * 1e9;
+
+		Biquad modulated(m, 0, 48000, fcMod[0], 0.707, 6);
+		t = benchNow();
+		for(int r = 0; r < RUNS; r++){
+			int i = r * FRAMES;
+			modulated.processBuffer(x + i, fcMod + i, b + i, FRAMES);
+		}
+		double after = (benchNow() - t) / n * 1e9;
+
+		double err = 0;
+		for(int i = 0; i < n; i++){
+			if(std::fabs(a[i] - b[i]) > err) err = std::fabs(a[i] - b[i]);
+		}
+		printf("%-10s setFc %7.2f ns  modulated %6.2f ns per sample  (%.1fx)  max difference %.2g\n",
+			names[m], before, after, before / after, err);
+	}
+
+	delete[] x;
+	delete[] fcMod;
+	delete[] a;
+	delete[] b;
+	return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * Measures the cost of a continuous cutoff sweep with
+ * Biquad::processBufferSmoothed at several smoothing intervals,
+ * against a full redesign with setFc before every sample.
+ *
+ * g++ -O2 -std=c++11 -I. bench/BiquadSmoothingBench.cpp Biquad.cpp BiquadCache.cpp -pthread -o smoothing_bench
+ */
+#include "Biquad.h"
+#include "Bench.h"
+
+#define FRAMES 512
+#define RUNS 2000
+
+//sweep between two cutoffs, one block per step
+static double sweep(int r){
+	return 200 + 4000 * (0.5 + 0.5 * std::sin(r * 0.01));
+}
+
+int main(){
+	Denormals::setEnabled(true);
+	double *x = new double[FRAMES];
+	double *y = new double[FRAMES];
+	benchNoise(x, FRAMES);
+	double samples = (double)FRAMES * RUNS;
+
+	Biquad perSample(1, 0, 48000, sweep(0), 0.707);
+	double t = benchNow();
+	for(int r = 0; r < RUNS; r++){
+		double f0 = perSample.getFc();
+		double df = (sweep(r + 1) - f0) / FRAMES;
+		for(int i = 0; i < FRAMES; i++){
+			perSample.setFc(f0 + df * (i + 1), true);
+			perSample.processBuffer(x + i, y + i, 1);
+		}
+	}
+	double before = benchReport("setFc per sample", benchNow() - t, samples);
+	benchSink = y[FRAMES - 1];
+
+	int intervals[] = {16, 32, 64};
+	for(int k = 0; k < 3; k++){
+		Biquad smoothed(1, 0, 48000, sweep(0), 0.707);
+		smoothed.setSmoothing(intervals[k]);
+		t = benchNow();
+		for(int r = 0; r < RUNS; r++){
+			smoothed.setTargets(sweep(r + 1), 0.707, 0);
+			smoothed.processBufferSmoothed(x, y, FRAMES);
+		}
+		char name[64];
+		snprintf(name, sizeof(name), "smoothed, interval %d", intervals[k]);
+		double after = benchReport(name, benchNow() - t, samples);
+		benchSink = y[FRAMES - 1];
+		printf("speedup %.1fx\n", before / after);
+	}
+
+	delete[] x;
+	delete[] y;
+	return 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * Compares Biquad::processBuffer, the normalized transposed direct
+ * form II kernel, with the per sample interface (updateXs,
+ * generateOutputSample and updateYs) it replaced as the block path.
+ *
+ * g++ -O2 -std=c++11 -I. bench/BiquadTDF2Bench.cpp Biquad.cpp BiquadCache.cpp -pthread -o tdf2_bench
+ */
+#include "Biquad.h"
+#include "Bench.h"
+
+#define FRAMES 4096
+#define RUNS 2000
+
+int main(){
+	Denormals::setEnabled(true);
+	double *x = new double[FRAMES];
+	double *y = new double[FRAMES];
+	benchNoise(x, FRAMES);
+	double samples = (double)FRAMES * RUNS;
+
+	Biquad legacy(1, 0, 48000, 1000, 0.707);
+	double t = benchNow();
+	for(int r = 0; r < RUNS; r++){
+		for(int i = 0; i < FRAMES; i++){
+			legacy.updateXs(x[i]);
+			y[i] = legacy.generateOutputSample();
+			legacy.updateYs(y[i]);
+		}
+	}
+	double before = benchReport("generateOutputSample", benchNow() - t, samples);
+	benchSink = y[FRAMES - 1];
+
+	Biquad tdf2(1, 0, 48000, 1000, 0.707);
+	t = benchNow();
+	for(int r = 0; r < RUNS; r++) tdf2.processBuffer(x, y, FRAMES);
+	double after = benchReport("processBuffer (TDF-II)", benchNow() - t, samples);
+	benchSink = y[FRAMES - 1];
+
+	printf("speedup %.2fx\n", before / after);
+	delete[] x;
+	delete[] y;
+	return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * Measures the cost of the silent tail of the recursive processors,
+ * with the denormal protection of Denormals off and on. Each
+ * processor is excited by one impulse and then fed silence, so its
+ * feedback state decays into subnormal numbers.
+ *
+ * g++ -O2 -std=c++11 -I. bench/DenormalsBench.cpp Biquad.cpp BiquadCache.cpp LinkwitzRiley.cpp modalURB.cpp ResonatorBank.cpp -pthread -o denormals_bench
+ */
+#include "Biquad.h"
+#include "LinkwitzRiley.h"
+#include "ModalURB.h"
+#include "Bench.h"
+#include <cstring>
+
+#define FRAMES 256
+//10 seconds at 48 kHz
+#define BLOCKS 1875
+//number of filters, to make the tail measurable
+#define FILTERS 64
+
+static double biquadTail(){
+	Biquad *f[FILTERS];
+	double x[FRAMES], y[FRAMES];
+	for(int k = 0; k < FILTERS; k++){
+		f[k] = new Biquad(1, 0, 48000, 100 + 50 * k, 0.707);
+		memset(x, 0, sizeof(x));
+		x[0] = 1;
+		f[k]->processBuffer(x, y, FRAMES);
+	}
+	memset(x, 0, sizeof(x));
+	double t = benchNow();
+	for(int b = 0; b < BLOCKS; b++){
+		for(int k = 0; k < FILTERS; k++) f[k]->processBuffer(x, y, FRAMES);
+	}
+	t = benchNow() - t;
+	benchSink = y[FRAMES - 1];
+	for(int k = 0; k < FILTERS; k++) delete f[k];
+	return t;
+}
+
+static double crossoverTail(){
+	LinkwitzRiley *f[FILTERS];
+	double x[FRAMES], lo[FRAMES], hi[FRAMES];
+	for(int k = 0; k < FILTERS; k++){
+		f[k] = new LinkwitzRiley(48000, 100 + 50 * k);
+		memset(x, 0, sizeof(x));
+		x[0] = 1;
+		f[k]->processBuffer(x, lo, hi, FRAMES);
+	}
+	memset(x, 0, sizeof(x));
+	double t = benchNow();
+	for(int b = 0; b < BLOCKS; b++){
+		for(int k = 0; k < FILTERS; k++) f[k]->processBuffer(x, lo, hi, FRAMES);
+	}
+	t = benchNow() - t;
+	benchSink = lo[FRAMES - 1] + hi[FRAMES - 1];
+	for(int k = 0; k < FILTERS; k++) delete f[k];
+	return t;
+}
+
+static double modalTail(){
+	ModalURB synth(48000);
+	//the notes last longer than the benchmark, only their resonators decay
+	synth.setNoteLength(60);
+	for(int v = 0; v < synth.getNumVoices(); v++) synth.noteOn(100 + 50 * v, 1);
+	double y[FRAMES];
+	double t = benchNow();
+	for(int b = 0; b < BLOCKS; b++) synth.processBuffer(y, FRAMES);
+	t = benchNow() - t;
+	benchSink = y[FRAMES - 1];
+	return t;
+}
+
+static void run(const char *name, double (*tail)()){
+	Denormals::setEnabled(false);
+	double off = tail();
+	Denormals::setEnabled(true);
+	double on = tail();
+	printf("%-14s off %8.2f ms  on %8.2f ms  (%.1fx)\n", name, off * 1e3, on * 1e3, off / on);
+}
+
+int main(){
+	printf("10 s of silent tail, hardware flush %s\n", Denormals::hasHardwareFlush() ? "available" : "not available");
+	run("Biquad", biquadTail);
+	run("LinkwitzRiley", crossoverTail);
+	run("ModalURB", modalTail);
+	return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * Measures ModalURB::generateNote, whose resonators are seeded with
+ * the impulse response of the modes and only run their feedback,
+ * against the previous path: an impulse buffer pushed through one
+ * band pass Biquad per mode and summed. The buffers of the previous
+ * path are allocated once, so only the processing is compared. The
+ * largest difference between the two notes is printed as well.
+ *
+ * g++ -O2 -std=c++11 -I. bench/ModalExcitationBench.cpp Biquad.cpp BiquadCache.cpp modalURB.cpp ResonatorBank.cpp -pthread -o modal_bench
+ */
+#include "Biquad.h"
+#include "ModalURB.h"
+#include "Bench.h"
+
+//2 s at 48 kHz
+#define FRAMES 96000
+#define NOTES 50
+
+//the default mode table of ModalURB
+static const double ratios[MODAL_MODES] = {0.4863636364, 0.9318181818, 1, 1.0136363636,
+	2.0045454545, 3.0136363636, 6.0090909091, 5.0181818182};
+static const double bws[MODAL_MODES] = {3, 1, 2, 2, 2, 2, 4, 3};
+static const double amps[MODAL_MODES] = {0.0885, 0.3393, 0.5523, 0.4367, 0.9, 0.121, 0.2951, 0.0369};
+
+/**
+ * impulseNote renders a note the way generateNote did before the
+ * resonators: band pass filters designed with the octave bandwidth
+ */
+static void impulseNote(double f, double *impulse, double *mode, double *output, int nFrames){
+	for(int i = 0; i < nFrames; i++) output[i] = 0;
+	for(int m = 0; m < MODAL_MODES; m++){
+		Biquad bp(0, 1);
+		bp.setParamsBW(48000, f * ratios[m], bws[m]);
+		bp.processBuffer(impulse, mode, nFrames);
+		for(int i = 0; i < nFrames; i++) output[i] += amps[m] * mode[i];
+	}
+	for(int i = 0; i < nFrames; i++) output[i] *= (double)(nFrames - (i + 1)) / nFrames;
+}
+
+int main(){
+	Denormals::setEnabled(true);
+	double *impulse = new double[FRAMES];
+	double *mode = new double[FRAMES];
+	double *a = new double[FRAMES];
+	double *b = new double[FRAMES];
+	impulse[0] = 1;
+	for(int i = 1; i < FRAMES; i++) impulse[i] = 0;
+
+	double t = benchNow();
+	for(int n = 0; n < NOTES; n++) impulseNote(110 * (1 + n * 0.05), impulse, mode, a, FRAMES);
+	double before = (benchNow() - t) / NOTES;
+	benchSink = a[FRAMES / 2];
+
+	ModalURB synth(48000);
+	t = benchNow();
+	for(int n = 0; n < NOTES; n++) synth.generateNote(110 * (1 + n * 0.05), b, FRAMES);
+	double after = (benchNow() - t) / NOTES;
+	benchSink = b[FRAMES / 2];
+
+	//compare the last note of both paths
+	double err = 0, peak = 0;
+	for(int i = 0; i < FRAMES; i++){
+		if(std::fabs(a[i] - b[i]) > err) err = std::fabs(a[i] - b[i]);
+		if(std::fabs(a[i]) > peak) peak = std::fabs(a[i]);
+	}
+
+	printf("%-28s %8.3f ms/note\n", "impulse through Biquads", before * 1e3);
+	printf("%-28s %8.3f ms/note  (%.1fx)\n", "ModalURB::generateNote", after * 1e3, before / after);
+	printf("max difference %.2g of a peak of %.2g\n", err, peak);
+
+	delete[] impulse;
+	delete[] mode;
+	delete[] a;
+	delete[] b;
+	return 0;
+}
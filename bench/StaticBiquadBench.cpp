@@ -0,0 +1,81 @@
+/**
+ * Measures the design throughput under cutoff automation of the
+ * runtime Biquad, redesigned with setFc, against the specialized
+ * StaticBiquad of the same mode: designs alone, then one design per
+ * block of AUTOMATION_BLOCK samples. A low shelf with a slope and a
+ * band pass designed with FastMath are measured.
+ *
+ * g++ -O2 -std=c++11 -I. bench/StaticBiquadBench.cpp Biquad.cpp BiquadCache.cpp -pthread -o static_bench
+ */
+#include "StaticBiquad.h"
+#include "Bench.h"
+
+#define DESIGNS 2000000
+#define AUTOMATION_BLOCK 32
+
+//automation value of step i, so that no two designs in a row are the same
+static double cutoff(int i){
+	return 100 + (i % 1000) * 3.7;
+}
+
+static void redesign(Biquad &f, double fc){
+	f.setFc(fc, true);
+}
+
+template<unsigned int M, unsigned int BWM>
+static void redesign(StaticBiquad<M, BWM> &f, double fc){
+	f.setFc(fc);
+}
+
+/**
+ * measure times the designs alone and the automated processing
+ * @param f The filter
+ * @param design Set to the cost of a design in ns
+ * @param automated Set to the cost of the automated processing in ns per sample
+ */
+template<typename F>
+static void measure(F &f, double &design, double &automated){
+	double as[3], bs[3];
+	double t = benchNow();
+	for(int i = 0; i < DESIGNS; i++) redesign(f, cutoff(i));
+	design = (benchNow() - t) / DESIGNS * 1e9;
+	f.getNormCoFs(as, bs);
+	benchSink = bs[0];
+
+	double x[AUTOMATION_BLOCK], y[AUTOMATION_BLOCK];
+	benchNoise(x, AUTOMATION_BLOCK);
+	int blocks = DESIGNS / 4;
+	t = benchNow();
+	for(int i = 0; i < blocks; i++){
+		redesign(f, cutoff(i));
+		f.processBuffer(x, y, AUTOMATION_BLOCK);
+	}
+	automated = (benchNow() - t) / ((double)blocks * AUTOMATION_BLOCK) * 1e9;
+	benchSink = y[0];
+}
+
+static void report(const char *name, double *runtime, double *fixed){
+	printf("%s\n", name);
+	printf("  design     Biquad %7.2f ns  StaticBiquad %7.2f ns  (%.2fx)\n", runtime[0], fixed[0], runtime[0] / fixed[0]);
+	printf("  automated  Biquad %7.2f ns  StaticBiquad %7.2f ns  (%.2fx) per sample\n", runtime[1], fixed[1], runtime[1] / fixed[1]);
+}
+
+int main(){
+	Denormals::setEnabled(true);
+	double runtime[2], fixed[2];
+
+	Biquad shelf(5, 2, 48000, cutoff(0), 1, 6);
+	StaticBiquad<LowShelf, SlopeBW> staticShelf(48000, cutoff(0), 1, 6);
+	measure(shelf, runtime[0], runtime[1]);
+	measure(staticShelf, fixed[0], fixed[1]);
+	report("low shelf, slope 1, +6 dB", runtime, fixed);
+
+	Biquad bandPass(0, 0, 48000, cutoff(0), 2);
+	StaticBiquad<BandPass, QBW> staticBandPass(48000, cutoff(0), 2);
+	bandPass.setFastMath(true);
+	staticBandPass.setFastMath(true);
+	measure(bandPass, runtime[0], runtime[1]);
+	measure(staticBandPass, fixed[0], fixed[1]);
+	report("band pass, Q 2, FastMath", runtime, fixed);
+	return 0;
+}
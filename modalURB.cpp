@@ -1,63 +1,388 @@
 #include "ModalURB.h"
 
-ModalURB::ModalURB(double fs){
+/**
+ * Creates an engine with MODAL_VOICES voices
+ * @param fs The sample rate
+ */
+ModalURB::ModalURB(double fs) : ModalURB(fs, MODAL_VOICES){
+}
+
+/**
+ * Creates an engine
+ * @param fs The sample rate
+ * @param n The number of voices
+ * @param m The largest number of modes of the mode table
+ */
+ModalURB::ModalURB(double fs, int n, int m){
+	static const double defRatios[MODAL_MODES] = {0.4863636364, 0.9318181818, 1, 1.0136363636,
+		2.0045454545, 3.0136363636, 6.0090909091, 5.0181818182};
+	static const double defBws[MODAL_MODES] = {3, 1, 2, 2, 2, 2, 4, 3};
+	static const double defAmps[MODAL_MODES] = {0.0885, 0.3393, 0.5523, 0.4367, 0.9, 0.121, 0.2951, 0.0369};
+
 	Fs = fs;
-	bws = {3, 1, 2, 2, 2, 2, 4, 3};
-	amps = {0.0885, 0.3393, 0.5523, 0.4367, 0.9, 0.121, 0.2951, 0.0369};
-	for(int i = 0; i < 8; i++){
-		filters[i] = new Biquad(0, 1);
-		filters[i].setFs(Fs);
+	f0 = 0;
+
+	maxModes = m > 0 ? m : 1;
+	//one block for the four tables
+	ratios = new double[4 * maxModes];
+	amps = ratios + maxModes;
+	bws = amps + maxModes;
+	freqs = bws + maxModes;
+	nModes = 0;
+	if(!setModes(defRatios, defAmps, defBws, MODAL_MODES)){
+		setModes(defRatios, defAmps, defBws, maxModes);
 	}
+
+	nVoices = n > 0 ? n : 1;
+	voiceLanes = (maxModes + BANK_WIDTH - 1) / BANK_WIDTH * BANK_WIDTH;
+	//lanes of the voices, of generateNote, of the shadow voices, then of streamNote
+	bank = new ResonatorBank((2 * nVoices + 2) * voiceLanes);
+	voices = new ModalVoice[2 * nVoices];
+	fades = voices + nVoices;
+	for(int v = 0; v < nVoices; v++){
+		initVoice(voices[v], v * voiceLanes);
+		initVoice(fades[v], (nVoices + 1 + v) * voiceLanes);
+	}
+	initVoice(offline, nVoices * voiceLanes);
+	initVoice(stream, (2 * nVoices + 1) * voiceLanes);
+	noteCounter = 0;
+
+	setNoteLength(2.0);
+	setRelease(0.05);
+	stealLength = (int)(MODAL_STEAL_FADE * Fs);
+	if(stealLength < 1) stealLength = 1;
 }
 
-void ModalURB::updateParams(double f){
-	updateFreqs(f);
-	for(int i = 0; i < 8; i++){
-		filters[i].setFc(f[i], true);
+ModalURB::~ModalURB(){
+	delete bank;
+	delete[] voices;
+	delete[] ratios;
+}
+
+/**
+ * initVoice clears a voice and gives it its resonators
+ * @param v The voice
+ * @param lane The first resonator of the voice
+ */
+void ModalURB::initVoice(ModalVoice &v, int lane){
+	v.active = false;
+	v.excite = false;
+	v.f0 = 0;
+	v.amp = 0;
+	v.env = 0;
+	v.envStep = 0;
+	v.start = 0;
+	v.age = 0;
+	v.lane = lane;
+	v.nModes = 0;
+}
+
+/**
+ * setModes replaces the mode table. The playing voices keep
+ * their modes, the new table is used by the next notes.
+ * @param r The frequency ratios of the modes to the fundamental
+ * @param a The gains of the modes
+ * @param b The bandwidths of the modes in octaves
+ * @param n The number of modes
+ * @return false IFF n is above the maximum given to the constructor
+ * or a ratio or a bandwidth is not positive. The table is then unchanged.
+ */
+bool ModalURB::setModes(const double *r, const double *a, const double *b, int n){
+	if(n < 0 || n > maxModes) return false;
+	for(int i = 0; i < n; i++){
+		if(!(r[i] > 0) || !(b[i] > 0)) return false;
 	}
+	for(int i = 0; i < n; i++){
+		ratios[i] = r[i];
+		amps[i] = a[i];
+		bws[i] = b[i];
+	}
+	nModes = n;
+	return true;
 }
 
+/**
+ * getModeHash hashes the mode table, so that notes rendered
+ * with different tables can be told apart.
+ * @return A 64 bit FNV-1a hash of the used entries of the table
+ */
+unsigned long long ModalURB::getModeHash(){
+	unsigned long long h = 14695981039346656037ULL;
+	const double *tables[3] = {ratios, amps, bws};
+	for(int t = 0; t < 3; t++){
+		const unsigned char *p = (const unsigned char*)tables[t];
+		for(size_t i = 0; i < nModes * sizeof(double); i++){
+			h ^= p[i];
+			h *= 1099511628211ULL;
+		}
+	}
+	h ^= (unsigned long long)nModes;
+	h *= 1099511628211ULL;
+	return h;
+}
 
+/**
+ * updateFreqs computes the mode frequencies of a note
+ * @param f The fundamental of the note
+ */
 void ModalURB::updateFreqs(double f){
 	f0 = f;
-	freqs[0] = 0.4863636364 * f0;
-	freqs[1] = 0.9318181818 * f0;
-	freqs[2] = f0;
-	freqs[3] = 1.0136363636 * f0;
-	freqs[4] = 2.0045454545 * f0;
-	freqs[5] = 3.0136363636 * f0;
-	freqs[6] = 6.0090909091 * f0;
-	freqs[7] = 5.0181818182 * f0;
+	for(int i = 0; i < nModes; i++) freqs[i] = ratios[i] * f0;
 }
 
-void ModalURB::generateNote(double f, double *output, int nFrames){
-	updateParams(f);
-
-	//create an impulse
-	double *impulse = (double *) malloc(sizeof(double) * nFrames);
-	impulse[0] = 1;
-	for(int i = 1; i < nFrames; i++){
-		impulse[i] = 0;
-	}
-	
-	//clear output buffer
-	for(int j = 0; j < nFrames; j++){
-		output[j] = 0;
-	}
-	
-	//apply imulse to each filter
-	for(int i = 0; i < 8; i++){
-		double *out = (double *) malloc(sizeof(double)*nFrames);
-		filters[i].processBuffer(impulse, out, nFrames);
-		
-		//copy the scaled filter output to the output buffer
-		for(int j = 0; j < nFrames; j++){
-			output[j] += amps[i] * out[j];
+/**
+ * setNoteLength sets the length of the linear decay of the notes
+ * @param s The length in seconds
+ */
+void ModalURB::setNoteLength(double s){
+	noteLength = (int)(s * Fs);
+	if(noteLength < 1) noteLength = 1;
+}
+
+/**
+ * setRelease sets the fade out applied by noteOff
+ * @param s The length in seconds
+ */
+void ModalURB::setRelease(double s){
+	releaseLength = (int)(s * Fs);
+	if(releaseLength < 1) releaseLength = 1;
+}
+
+/**
+ * getNumActive counts the voices playing
+ * @return The number of active voices
+ */
+int ModalURB::getNumActive(){
+	int n = 0;
+	for(int v = 0; v < nVoices; v++){
+		if(voices[v].active) n++;
+	}
+	return n;
+}
+
+/**
+ * startVoice tunes a voice to a note and restarts its envelope.
+ * The lanes of the voice past its last mode are cleared, so they
+ * stay silent when the kernel renders them with the others.
+ * @param v The voice
+ * @param f The fundamental of the note
+ * @param a The velocity gain of the note
+ * @param offset The sample of the next block where the note starts
+ * @return false IFF f is not positive, the voice is then unchanged
+ */
+bool ModalURB::startVoice(ModalVoice &v, double f, double a, int offset){
+	if(!(f > 0)) return false;
+	updateFreqs(f);
+	bank->clear(v.lane, voiceLanes);
+	v.nModes = 0;
+	for(int i = 0; i < nModes; i++){
+		//modes above Nyquist are not rendered
+		if(freqs[i] >= 0.49 * Fs) continue;
+		bank->tune(v.lane + v.nModes, Fs, freqs[i], bws[i], amps[i]);
+		v.nModes++;
+	}
+
+	v.active = true;
+	v.excite = true;
+	v.f0 = f;
+	v.amp = a;
+	v.env = 1;
+	v.envStep = 1.0 / noteLength;
+	v.start = offset > 0 ? offset : 0;
+	v.age = ++noteCounter;
+	return true;
+}
+
+/**
+ * renderVoice adds the next nFrames samples of a voice to the
+ * output. The voice is freed when its envelope reaches 0.
+ * @param v The voice
+ * @param output The output buffer
+ * @param nFrames The number of samples
+ */
+void ModalURB::renderVoice(ModalVoice &v, double *output, int nFrames){
+	int s = v.start;
+	if(s >= nFrames){
+		v.start -= nFrames;
+		return;
+	}
+	v.start = 0;
+	int n = nFrames - s;
+
+	//seed the oscillators and add the first sample they do not give
+	if(v.excite){
+		double first = 0;
+		for(int m = 0; m < v.nModes; m++) first += bank->excite(v.lane + m, 1);
+		output[s] += v.amp * v.env * first;
+		v.excite = false;
+	}
+
+	//stop after the last sample with a positive envelope
+	int left = (int)ceil(v.env / v.envStep);
+	if(left <= n){
+		n = left;
+		v.active = false;
+	}
+
+	bank->process(v.lane, v.nModes, v.amp * v.env, v.amp * v.envStep, output + s, n);
+	v.env -= n * v.envStep;
+}
+
+/**
+ * noteOn starts a note. If no voice is free the quietest one
+ * is stolen: its resonators and envelope are moved to a free
+ * shadow voice, which fades the note out from the start of the
+ * next block, so the new note does not cut it. If every shadow
+ * voice is fading, the quietest fade is cut instead.
+ * @param f The fundamental of the note in Hz
+ * @param a The velocity gain of the note
+ * @param offset The sample of the next block where the note starts
+ * @return The voice playing the note, or -1 if f is not positive
+ */
+int ModalURB::noteOn(double f, double a, int offset){
+	if(!(f > 0)) return -1;
+	int best = 0;
+	double quietest = 0;
+	for(int v = 0; v < nVoices; v++){
+		if(!voices[v].active){
+			best = v;
+			break;
+		}
+		//the oldest of the quietest voices
+		double level = voices[v].amp * voices[v].env;
+		if(v == 0 || level < quietest || (level == quietest && voices[v].age < voices[best].age)){
+			best = v;
+			quietest = level;
+		}
+	}
+	ModalVoice &voice = voices[best];
+	if(voice.active){
+		//a free shadow voice, else the quietest one is cut
+		int slot = 0;
+		double faintest = 0;
+		for(int v = 0; v < nVoices; v++){
+			if(!fades[v].active){
+				slot = v;
+				break;
+			}
+			double level = fades[v].amp * fades[v].env;
+			if(v == 0 || level < faintest){
+				slot = v;
+				faintest = level;
+			}
 		}
+		ModalVoice &fade = fades[slot];
+		int lane = fade.lane;
+		fade = voice;
+		fade.lane = lane;
+		bank->copy(voice.lane, fade.lane, voiceLanes);
+		double step = fade.env / stealLength;
+		if(step > fade.envStep) fade.envStep = step;
+	}
+	startVoice(voice, f, a, offset);
+	return best;
+}
+
+/**
+ * noteOff releases every voice playing the fundamental f
+ * @param f The fundamental of the note in Hz
+ */
+void ModalURB::noteOff(double f){
+	for(int v = 0; v < nVoices; v++){
+		ModalVoice &voice = voices[v];
+		if(!voice.active || voice.f0 != f) continue;
+		double step = voice.env / releaseLength;
+		if(step > voice.envStep) voice.envStep = step;
 	}
+}
+
+/**
+ * allNotesOff stops every voice immediately
+ */
+void ModalURB::allNotesOff(){
+	for(int v = 0; v < 2 * nVoices; v++) voices[v].active = false;
+}
 
-	//apply a linear envelope to the output
-	for(int i = 0; i < nFrames; i++){
-		output[i] *= ( nFrames - (i+1) ) / nFrames;
+/**
+ * processBuffer renders the next block of every active voice.
+ * The voices are rendered straight into the output, so a block
+ * may have any size.
+ * @param output The output buffer, overwritten
+ * @param nFrames The number of samples
+ */
+void ModalURB::processBuffer(double *output, int nFrames){
+	if(nFrames < 1) return;
+	ScopedNoDenormals noDenormals;
+	for(int i = 0; i < nFrames; i++) output[i] = 0;
+	//the voices, then the stolen notes fading out
+	for(int v = 0; v < 2 * nVoices; v++){
+		if(!voices[v].active) continue;
+		renderVoice(voices[v], output, nFrames);
+		if(noDenormals.needsFlush()) bank->flush(voices[v].lane, voiceLanes);
 	}
-}
\ No newline at end of file
+}
+
+/**
+ * generateNote renders a whole note offline with a linear
+ * envelope over nFrames. It uses its own voice, so neither the
+ * playing voices nor the note of startNote are affected.
+ * The note is silent if f is not positive, and nothing is
+ * rendered if nFrames is below 1.
+ * @param f The fundamental of the note
+ * @param output The output buffer
+ * @param nFrames The length of the note in samples
+ */
+void ModalURB::generateNote(double f, double *output, int nFrames){
+	if(nFrames < 1) return;
+	ScopedNoDenormals noDenormals;
+	for(int i = 0; i < nFrames; i++) output[i] = 0;
+	if(!startVoice(offline, f, 1, 0)) return;
+	offline.envStep = 1.0 / nFrames;
+	renderVoice(offline, output, nFrames);
+}
+
+/**
+ * startNote starts a note on the stream voice, to be rendered
+ * block by block with streamNote. The stream voice has its own
+ * resonators, so the pool, noteOn and generateNote do not affect
+ * it.
+ * @param f The fundamental of the note
+ * @param a The velocity gain of the note
+ * @param nFrames The length of the envelope in samples, or 0 for
+ * the length set in seconds by setNoteLength
+ * @return false IFF f is not positive or nFrames is negative
+ */
+bool ModalURB::startNote(double f, double a, int nFrames){
+	if(nFrames < 0 || !startVoice(stream, f, a, 0)) return false;
+	if(nFrames > 0) stream.envStep = 1.0 / nFrames;
+	return true;
+}
+
+/**
+ * stopNote releases the note started by startNote over the
+ * length set by setRelease
+ */
+void ModalURB::stopNote(){
+	if(!stream.active) return;
+	double step = stream.env / releaseLength;
+	if(step > stream.envStep) stream.envStep = step;
+}
+
+/**
+ * streamNote renders the next block of the note started by
+ * startNote. The cost of a block only depends on its size.
+ * @param output The output buffer, overwritten
+ * @param nFrames The number of samples
+ * @return The number of samples of the block before the end of
+ * the note, the rest is silent; 0 once the note is over
+ */
+int ModalURB::streamNote(double *output, int nFrames){
+	for(int i = 0; i < nFrames; i++) output[i] = 0;
+	if(!stream.active || nFrames <= 0) return 0;
+
+	ScopedNoDenormals noDenormals;
+	int left = (int)ceil(stream.env / stream.envStep);
+	renderVoice(stream, output, nFrames);
+	if(noDenormals.needsFlush()) bank->flush(stream.lane, voiceLanes);
+	return left < nFrames ? left : nFrames;
+}
@@ -0,0 +1,98 @@
+/**
+ * Checks Biquad::processBufferLookahead against processBuffer for
+ * every mode, on buffers of lengths that are not multiples of the
+ * 4 sample block, and measures the throughput of both paths.
+ * Returns 1 if any output differs by more than the tolerance.
+ *
+ * g++ -O2 -std=c++11 -I. tests/BiquadLookaheadTest.cpp Biquad.cpp BiquadCache.cpp -pthread -o lookahead_test
+ */
+#include "Biquad.h"
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+//largest error allowed, relative to the peak of the reference
+#define TOLERANCE 1e-9
+#define BENCH_FRAMES 4096
+#define BENCH_RUNS 2000
+
+static double now(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * check filters the same noise with both paths, in buffers of
+ * random lengths, and compares the outputs
+ * @return The largest error relative to the peak of the reference
+ */
+static double check(unsigned int mode, unsigned int bwm, double fc, double bw, double dbg){
+	Biquad ref(mode, bwm, 48000, fc, bw, dbg);
+	Biquad la(mode, bwm, 48000, fc, bw, dbg);
+	const int n = 10007;
+	double *x = new double[n];
+	double *a = new double[n];
+	double *b = new double[n];
+	for(int i = 0; i < n; i++) x[i] = rand() / (double)RAND_MAX * 2 - 1;
+
+	//odd sizes so that every block remainder is used
+	for(int i = 0; i < n;){
+		int len = 1 + rand() % 67;
+		if(len > n - i) len = n - i;
+		ref.processBuffer(x + i, a + i, len);
+		la.processBufferLookahead(x + i, b + i, len);
+		i += len;
+	}
+
+	double peak = 0, err = 0;
+	for(int i = 0; i < n; i++){
+		if(std::fabs(a[i]) > peak) peak = std::fabs(a[i]);
+		if(std::fabs(a[i] - b[i]) > err) err = std::fabs(a[i] - b[i]);
+	}
+	delete[] x;
+	delete[] a;
+	delete[] b;
+	return peak > 0 ? err / peak : err;
+}
+
+/**
+ * bench measures one path in millions of samples per second
+ */
+static double bench(bool lookahead){
+	Biquad f(1, 0, 48000, 1000, 0.707);
+	double *x = new double[BENCH_FRAMES];
+	for(int i = 0; i < BENCH_FRAMES; i++) x[i] = rand() / (double)RAND_MAX * 2 - 1;
+	double t = now();
+	for(int r = 0; r < BENCH_RUNS; r++){
+		if(lookahead) f.processBufferLookahead(x, x, BENCH_FRAMES);
+		else f.processBuffer(x, x, BENCH_FRAMES);
+	}
+	t = now() - t;
+	//keep the output alive
+	volatile double sink = x[0];
+	(void)sink;
+	delete[] x;
+	return (double)BENCH_FRAMES * BENCH_RUNS / t / 1e6;
+}
+
+int main(){
+	Denormals::setEnabled(true);
+	srand(1);
+	const char *names[] = {"band pass", "low pass", "high pass", "notch", "all pass", "low shelf", "high shelf"};
+	int failed = 0;
+	for(unsigned int m = 0; m < 7; m++){
+		double fcs[] = {20, 1000, 18000};
+		for(int i = 0; i < 3; i++){
+			//slope for the shelves, Q for the others
+			double err = m >= 5 ? check(m, 2, fcs[i], 1, 6) : check(m, 0, fcs[i], 0.707, 0);
+			bool ok = err <= TOLERANCE;
+			if(!ok) failed++;
+			printf("%-10s %6.0f Hz  error %.3g  %s\n", names[m], fcs[i], err, ok ? "ok" : "FAILED");
+		}
+	}
+
+	double tdf2 = bench(false);
+	double la = bench(true);
+	printf("processBuffer           %8.1f Msamples/s\n", tdf2);
+	printf("processBufferLookahead  %8.1f Msamples/s  (%.2fx)\n", la, la / tdf2);
+	return failed ? 1 : 0;
+}